@@ -5,6 +5,8 @@
 #include "Error.hpp"
 #include "Types.hpp"
 #include "LocaleManager.hpp"
+#include "FileIO.hpp"
+#include "StringUtils.hpp"
 #include <thread>
 #include <chrono>
 #include <cmath> // For sin, cos, etc.
@@ -19,6 +21,13 @@
 #include <iomanip> 
 #include <sstream>
 #include <unordered_set>
+#include <queue>
+#include <charconv>
+#include <cstring>
+#include <bit>
+#include <functional>
+#include <list>
+#include <limits>
 #include <cstdlib> 
 #include <format>
 
@@ -251,6 +260,31 @@ namespace {
         {5, {{-0.9061798459386640, -0.5384693101056831, 0.0, 0.5384693101056831, 0.9061798459386640}, {0.2369268850561891, 0.4786286704993665, 0.5688888888888889, 0.4786286704993665, 0.2369268850561891}}}
     };
 
+    // Number of threads worth using for n independent items when every thread should get
+    // at least min_chunk of them. Returns 1 for small inputs.
+    size_t worker_count(size_t n, size_t min_chunk) {
+        size_t hw = std::max<size_t>(1, std::thread::hardware_concurrency());
+        return std::max<size_t>(1, std::min(hw, n / std::max<size_t>(1, min_chunk)));
+    }
+
+    // Splits [0, n) into 'workers' contiguous blocks and runs body(w, begin, end) for each
+    // block on its own thread. With a single worker the body runs on the calling thread.
+    template <typename Body>
+    void run_blocks(size_t n, size_t workers, Body body) {
+        if (workers <= 1) {
+            body(size_t{ 0 }, size_t{ 0 }, n);
+            return;
+        }
+        const size_t block = (n + workers - 1) / workers;
+        std::vector<std::thread> pool;
+        for (size_t w = 0; w < workers; ++w) {
+            size_t begin = w * block;
+            size_t end = std::min(n, begin + block);
+            if (begin < end) pool.emplace_back(body, w, begin, end);
+        }
+        for (auto& t : pool) t.join();
+    }
+
     // Solves the linear system Ax = b for x using LU Decomposition with partial pivoting.
     // - A is the n x n coefficient matrix, passed as a flat vector.
     // - b is the n x 1 known vector.
@@ -350,49 +384,59 @@ namespace {
 
 // --- JSON Functionality ---
 
-// Forward declaration for recursive conversion
-nlohmann::json basic_to_json_value(const BasicValue& val);
-
-// Helper function to convert a BasicValue into a nlohmann::json object.
-nlohmann::json basic_to_json_value(const BasicValue& val) {
-    return std::visit([](auto&& arg) -> nlohmann::json {
+// Appends the compact JSON text of a BasicValue to 'out'. Arrays and Maps are written
+// directly instead of being rebuilt as an nlohmann::json tree first; object keys come out
+// in ascending order, like nlohmann::json's own objects. A JsonObject reuses its cached text.
+void append_json(std::string& out, const BasicValue& val) {
+    std::visit([&out](auto&& arg) {
         using T = std::decay_t<decltype(arg)>;
 
         if constexpr (std::is_same_v<T, bool> || std::is_same_v<T, double> || std::is_same_v<T, int> || std::is_same_v<T, std::string>) {
-            return nlohmann::json(arg);
+            out += nlohmann::json(arg).dump();
         }
         else if constexpr (std::is_same_v<T, std::shared_ptr<Array>>) {
-            if (!arg) return nlohmann::json::array();
-            nlohmann::json j_arr = nlohmann::json::array();
-            for (const auto& elem : arg->data) {
-                j_arr.push_back(basic_to_json_value(elem));
+            out += '[';
+            if (arg) {
+                for (size_t i = 0; i < arg->data.size(); ++i) {
+                    if (i > 0) out += ',';
+                    append_json(out, arg->data[i]);
+                }
             }
-            return j_arr;
+            out += ']';
         }
         else if constexpr (std::is_same_v<T, std::shared_ptr<Map>>) {
-            if (!arg) return nlohmann::json::object();
-            nlohmann::json j_obj = nlohmann::json::object();
-            for (const auto& pair : arg->data) {
-                j_obj[pair.first] = basic_to_json_value(pair.second);
+            out += '{';
+            if (arg) {
+                std::vector<const std::pair<std::string, BasicValue>*> entries;
+                entries.reserve(arg->data.size());
+                for (const auto& pair : arg->data) entries.push_back(&pair);
+                if (!arg->data.is_sorted()) {
+                    std::sort(entries.begin(), entries.end(), [](const auto* a, const auto* b) { return a->first < b->first; });
+                }
+                for (size_t i = 0; i < entries.size(); ++i) {
+                    if (i > 0) out += ',';
+                    out += nlohmann::json(entries[i]->first).dump();
+                    out += ':';
+                    append_json(out, entries[i]->second);
+                }
             }
-            return j_obj;
+            out += '}';
         }
         else if constexpr (std::is_same_v<T, std::shared_ptr<JsonObject>>) {
-            // If we encounter a JsonObject, just return its internal data.
-            return arg ? arg->data : nlohmann::json(nullptr);
+            out += arg ? arg->compact() : std::string("null");
         }
         else if constexpr (std::is_same_v<T, DateTime> || std::is_same_v<T, FunctionRef>) {
             // Convert these types to their string representation
-            return nlohmann::json(to_string(arg));
+            out += nlohmann::json(to_string(arg)).dump();
         }
 #ifdef JDCOM
         else if constexpr (std::is_same_v<T, ComObject>) {
-            return nlohmann::json("<COM Object>");
+            out += "\"<COM Object>\"";
         }
 #endif
         else {
-            // Should not be reached if all types are handled. Return null.
-            return nlohmann::json(nullptr);
+            // Should not be reached if all types are handled.
+            out += "null";
         }
         }, val);
 }
@@ -471,10 +515,10 @@ BasicValue builtin_json_stringify(NeReLaBasic& vm, const std::vector<BasicValue>
     const BasicValue& val_to_stringify = args[0];
 
     try {
-        nlohmann::json j = basic_to_json_value(val_to_stringify);
-        // dump() with no arguments creates a compact string, ideal for API calls.
-        // For pretty-printing, you could use j.dump(4)
-        return j.dump();
+        // A compact string, ideal for API calls.
+        std::string out;
+        append_json(out, val_to_stringify);
+        return out;
     }
     catch (const std::exception& e) {
         Error::set(15, vm.runtime_current_line); // Type Mismatch or other conversion error
@@ -483,6 +527,125 @@ BasicValue builtin_json_stringify(NeReLaBasic& vm, const std::vector<BasicValue>
     }
 }
 
+// --- Streaming JSON (JSON.OPEN / JSON.NEXT / JSON.SELECT) ---
+
+// Wraps a value read from a JSON stream: objects and arrays become a JsonObject (navigated
+// in place by accessor chains), plain values are converted right away.
+static BasicValue json_record_to_basic(nlohmann::json&& j) {
+    if (!j.is_object() && !j.is_array()) return json_to_basic_value(j);
+    auto json_obj_ptr = std::make_shared<JsonObject>();
+    json_obj_ptr->data = std::move(j);
+    return json_obj_ptr;
+}
+
+// Looks up the open JSON reader behind a handle argument. Sets an error if it is not open.
+static FileIO::JsonReader* get_json_reader(NeReLaBasic& vm, const BasicValue& handle) {
+    auto it = vm.json_readers.find(static_cast<int>(to_double(handle)));
+    if (it == vm.json_readers.end()) {
+        Error::set(12, vm.runtime_current_line, "JSON handle is not open.");
+        return nullptr;
+    }
+    return it->second.get();
+}
+
+// JSON.OPEN(filename$) -> handle
+// Opens a JSON file for reading record by record: the elements of a top-level array,
+// or the values of an NDJSON file (one JSON value per line).
+BasicValue builtin_json_open(NeReLaBasic& vm, const std::vector<BasicValue>& args) {
+    if (args.size() != 1) {
+        Error::set(8, vm.runtime_current_line);
+        return 0.0;
+    }
+    auto reader = std::make_unique<FileIO::JsonReader>();
+    if (!reader->open(to_string(args[0]))) {
+        Error::set(6, vm.runtime_current_line);
+        return 0.0;
+    }
+    int handle = vm.next_json_reader++;
+    vm.json_readers[handle] = std::move(reader);
+    return static_cast<double>(handle);
+}
+
+// JSON.NEXT(handle) -> JsonObject or value
+// Parses and returns the next record. Only this record is held in memory.
+BasicValue builtin_json_next(NeReLaBasic& vm, const std::vector<BasicValue>& args) {
+    if (args.size() != 1) {
+        Error::set(8, vm.runtime_current_line);
+        return {};
+    }
+    FileIO::JsonReader* reader = get_json_reader(vm, args[0]);
+    if (!reader) return {};
+
+    nlohmann::json record;
+    std::string error;
+    if (!reader->next(record, error)) {
+        if (error.empty()) Error::set(12, vm.runtime_current_line, "Read past end of file.");
+        else Error::set(1, vm.runtime_current_line, "JSON Parse Error: " + error);
+        return {};
+    }
+    return json_record_to_basic(std::move(record));
+}
+
+// JSON.EOF(handle) -> boolean
+// Returns TRUE when there are no more records.
+BasicValue builtin_json_eof(NeReLaBasic& vm, const std::vector<BasicValue>& args) {
+    if (args.size() != 1) {
+        Error::set(8, vm.runtime_current_line);
+        return true;
+    }
+    FileIO::JsonReader* reader = get_json_reader(vm, args[0]);
+    if (!reader) return true;
+    return reader->at_end();
+}
+
+// JSON.CLOSE handle
+// Closes a JSON reader opened with JSON.OPEN.
+BasicValue builtin_json_close(NeReLaBasic& vm, const std::vector<BasicValue>& args) {
+    if (args.size() != 1) {
+        Error::set(8, vm.runtime_current_line);
+        return false;
+    }
+    if (!get_json_reader(vm, args[0])) return false;
+    vm.json_readers.erase(static_cast<int>(to_double(args[0])));
+    return false;
+}
+
+// JSON.SELECT(filename$, path$) -> array
+// Streams a JSON or NDJSON file and returns the values at path$, e.g. "$.items[*].id".
+// Everything else in the file is parsed but never built in memory.
+BasicValue builtin_json_select(NeReLaBasic& vm, const std::vector<BasicValue>& args) {
+    if (args.size() != 2) {
+        Error::set(8, vm.runtime_current_line);
+        return {};
+    }
+    std::vector<FileIO::JsonPathStep> path;
+    std::string error;
+    if (!FileIO::parse_json_path(to_string(args[1]), path, error)) {
+        Error::set(1, vm.runtime_current_line, error);
+        return {};
+    }
+    FileIO::MappedFile file;
+    if (!file.open(to_string(args[0]))) {
+        Error::set(6, vm.runtime_current_line);
+        return {};
+    }
+    FileIO::MappedStreamBuf view;
+    view.attach(file.text());
+    std::istream in(&view);
+
+    std::vector<nlohmann::json> matches;
+    if (!FileIO::select_json(in, path, matches, error)) {
+        Error::set(1, vm.runtime_current_line, "JSON Parse Error: " + error);
+        return {};
+    }
+
+    auto result = std::make_shared<Array>();
+    result->data.reserve(matches.size());
+    for (auto& match : matches) result->data.push_back(json_record_to_basic(std::move(match)));
+    result->shape = { result->data.size() };
+    return result;
+}
+
 //=========================================================
 // NEW: Map Helper Functions
 //=========================================================
@@ -504,9 +667,8 @@ BasicValue builtin_map_exists(NeReLaBasic& vm, const std::vector<BasicValue>& ar
         return false;
     }
 
-    const std::string key = to_string(args[1]);
-
-    return map_ptr->data.count(key) > 0;
+    std::string key_buffer;
+    return map_ptr->data.count(to_key_view(args[1], key_buffer)) > 0;
 }
 
 // MAP.KEYS(map) -> array
@@ -632,6 +794,9 @@ BasicValue builtin_len(NeReLaBasic& vm, const std::vector<BasicValue>& args) {
     }
 
     // --- Case 3: Fallback to original behavior (length of string representation) ---
+    if (const auto* text = std::get_if<std::string>(&val)) {
+        return static_cast<double>(StringUtils::utf8_length(*text)); // Length in codepoints
+    }
     return static_cast<double>(to_string(val).length());
 }
 
@@ -751,69 +916,145 @@ BasicValue builtin_circle(NeReLaBasic& vm, const std::vector<BasicValue>& args)
 
 
 // --- String Functions ---
+// Positions and lengths count UTF-8 codepoints. ASCII text is indexed by byte directly;
+// other text is scanned with the word-at-a-time helpers in StringUtils.
+
+namespace {
+    // Byte offset of the first 'count' codepoints of s.
+    size_t char_offset(std::string_view s, bool ascii, size_t count) {
+        return ascii ? std::min(count, s.size()) : StringUtils::utf8_offset(s, count);
+    }
+
+    constexpr size_t PARALLEL_STRING_THRESHOLD = 1 << 14;
+
+    // The array argument of an element-wise call, or nullptr for a scalar.
+    const Array* array_arg(const BasicValue& value) {
+        const auto* arr = std::get_if<std::shared_ptr<Array>>(&value);
+        return arr && *arr ? arr->get() : nullptr;
+    }
+
+    // Strings, numbers and booleans convert without touching shared state. Objects do not
+    // (a JsonObject caches its text), so they are never converted from several threads.
+    bool is_plain_value(const BasicValue& value) {
+        return std::holds_alternative<std::string>(value) || std::holds_alternative<double>(value) ||
+            std::holds_alternative<int>(value) || std::holds_alternative<bool>(value);
+    }
+
+    // Applies fn to every element of src and returns the results in an array of the same
+    // shape. Large arrays of plain values are processed in parallel blocks, so fn must not
+    // touch the VM.
+    template <typename Fn>
+    std::shared_ptr<Array> map_elements(const Array& src, Fn fn) {
+        auto result = std::make_shared<Array>();
+        result->shape = src.shape;
+        result->data.resize(src.data.size());
+        const size_t n = src.data.size();
+        size_t workers = n < PARALLEL_STRING_THRESHOLD ? 1 : worker_count(n, PARALLEL_STRING_THRESHOLD / 4);
+        if (workers > 1 && !std::all_of(src.data.begin(), src.data.end(), is_plain_value)) workers = 1;
+        run_blocks(n, workers, [&](size_t, size_t begin, size_t end) {
+            for (size_t i = begin; i < end; ++i) result->data[i] = fn(src.data[i]);
+            });
+        return result;
+    }
+
+    std::string left_text(std::string s, int count) {
+        if (count < 0) count = 0;
+        s.resize(char_offset(s, StringUtils::is_ascii(s), count));
+        return s;
+    }
+
+    std::string right_text(const std::string& s, int count) {
+        if (count < 0) count = 0;
+        const bool ascii = StringUtils::is_ascii(s);
+        const size_t length = ascii ? s.length() : StringUtils::utf8_length(s);
+        if (static_cast<size_t>(count) > length) count = static_cast<int>(length);
+        return s.substr(char_offset(s, ascii, length - count));
+    }
+
+    // length < 0 takes the rest of the string.
+    std::string mid_text(const std::string& s, int start, int length) {
+        if (start < 0) start = 0;
+        const bool ascii = StringUtils::is_ascii(s);
+        const size_t begin = char_offset(s, ascii, start);
+        if (length < 0) return s.substr(begin);
+        return s.substr(begin, char_offset(std::string_view(s).substr(begin), ascii, length));
+    }
+
+    std::string trim_text(std::string s) {
+        s.erase(0, s.find_first_not_of(" \t\n\r"));
+        s.erase(s.find_last_not_of(" \t\n\r") + 1);
+        return s;
+    }
+}
+
+// String functions given an array as their text argument work element-wise and return an
+// array of the same shape, e.g. UCASE$(names$) or LEFT$(codes$, 3).
 
 // LEFT$(string, n)
 BasicValue builtin_left_str(NeReLaBasic& vm, const std::vector<BasicValue>& args) {
     if (args.size() != 2) return std::string("");
-    std::string source = to_string(args[0]);
-    int count = static_cast<int>(to_double(args[1]));
-    if (count < 0) count = 0;
-    return source.substr(0, count);
+    const int count = static_cast<int>(to_double(args[1]));
+    if (const Array* arr = array_arg(args[0])) {
+        return map_elements(*arr, [count](const BasicValue& v) -> BasicValue { return left_text(to_string(v), count); });
+    }
+    return left_text(to_string(args[0]), count);
 }
 
 // RIGHT$(string, n)
 BasicValue builtin_right_str(NeReLaBasic& vm, const std::vector<BasicValue>& args) {
     if (args.size() != 2) return std::string("");
-    std::string source = to_string(args[0]);
-    int count = static_cast<int>(to_double(args[1]));
-    if (count < 0) count = 0;
-    if (count > source.length()) count = source.length();
-    return source.substr(source.length() - count);
+    const int count = static_cast<int>(to_double(args[1]));
+    if (const Array* arr = array_arg(args[0])) {
+        return map_elements(*arr, [count](const BasicValue& v) -> BasicValue { return right_text(to_string(v), count); });
+    }
+    return right_text(to_string(args[0]), count);
 }
 
 // MID$(string, start, [length]) - Overloaded
 BasicValue builtin_mid_str(NeReLaBasic& vm, const std::vector<BasicValue>& args) {
     if (args.size() < 2 || args.size() > 3) return std::string("");
 
-    std::string source = to_string(args[0]);
-    int start = static_cast<int>(to_double(args[1])) - 1; // BASIC is 1-indexed
-    if (start < 0) start = 0;
+    const int start = static_cast<int>(to_double(args[1])) - 1; // BASIC is 1-indexed
+    int length = -1; // MID$(str, start) -> get rest of string
+    if (args.size() == 3) length = std::max(0, static_cast<int>(to_double(args[2])));
 
-    if (args.size() == 2) { // MID$(str, start) -> get rest of string
-        return source.substr(start);
-    }
-    else { // MID$(str, start, len)
-        int length = static_cast<int>(to_double(args[2]));
-        if (length < 0) length = 0;
-        return source.substr(start, length);
+    if (const Array* arr = array_arg(args[0])) {
+        return map_elements(*arr, [start, length](const BasicValue& v) -> BasicValue { return mid_text(to_string(v), start, length); });
     }
+    return mid_text(to_string(args[0]), start, length);
 }
 
 // LCASE$(string)
 BasicValue builtin_lcase_str(NeReLaBasic& vm, const std::vector<BasicValue>& args) {
     if (args.size() != 1) return std::string("");
-    std::string s = to_string(args[0]);
-    std::transform(s.begin(), s.end(), s.begin(),
-        [](unsigned char c) { return std::tolower(c); });
-    return s;
+    auto lower = [](const BasicValue& v) -> BasicValue {
+        std::string s = to_string(v);
+        StringUtils::utf8_to_lower(s);
+        return s;
+    };
+    if (const Array* arr = array_arg(args[0])) return map_elements(*arr, lower);
+    return lower(args[0]);
 }
 
 // UCASE$(string)
 BasicValue builtin_ucase_str(NeReLaBasic& vm, const std::vector<BasicValue>& args) {
     if (args.size() != 1) return std::string("");
-    std::string s = to_string(args[0]);
-    std::transform(s.begin(), s.end(), s.begin(),
-        [](unsigned char c) { return std::toupper(c); });
-    return s;
+    auto upper = [](const BasicValue& v) -> BasicValue {
+        std::string s = to_string(v);
+        StringUtils::utf8_to_upper(s);
+        return s;
+    };
+    if (const Array* arr = array_arg(args[0])) return map_elements(*arr, upper);
+    return upper(args[0]);
 }
 
 // TRIM$(string)
 BasicValue builtin_trim_str(NeReLaBasic& vm, const std::vector<BasicValue>& args) {
     if (args.size() != 1) return std::string("");
-    std::string s = to_string(args[0]);
-    s.erase(0, s.find_first_not_of(" \t\n\r"));
-    s.erase(s.find_last_not_of(" \t\n\r") + 1);
-    return s;
+    if (const Array* arr = array_arg(args[0])) {
+        return map_elements(*arr, [](const BasicValue& v) -> BasicValue { return trim_text(to_string(v)); });
+    }
+    return trim_text(to_string(args[0]));
 }
 
 // CHR$(number)
@@ -836,28 +1077,171 @@ BasicValue builtin_instr(NeReLaBasic& vm, const std::vector<BasicValue>& args) {
     if (args.size() < 2 || args.size() > 3) return 0.0;
 
     size_t start_pos = 0;
-    std::string haystack, needle;
-
-    if (args.size() == 2) {
-        haystack = to_string(args[0]);
-        needle = to_string(args[1]);
-    }
-    else {
+    size_t first = 0;
+    if (args.size() == 3) {
         start_pos = static_cast<size_t>(to_double(args[0])) - 1;
-        haystack = to_string(args[1]);
-        needle = to_string(args[2]);
+        first = 1;
     }
 
-    if (start_pos >= haystack.length()) return 0.0;
+    // String arguments are searched in place; anything else is converted first.
+    std::string haystack_text, needle_text;
+    const std::string* haystack = std::get_if<std::string>(&args[first]);
+    const std::string* needle = std::get_if<std::string>(&args[first + 1]);
+    if (!haystack) { haystack_text = to_string(args[first]); haystack = &haystack_text; }
+    if (!needle) { needle_text = to_string(args[first + 1]); needle = &needle_text; }
 
-    size_t found_pos = haystack.find(needle, start_pos);
+    const bool ascii = StringUtils::is_ascii(*haystack);
+    const size_t byte_start = char_offset(*haystack, ascii, start_pos);
+    if (byte_start >= haystack->length()) return 0.0;
+
+    size_t found_pos = StringUtils::find(*haystack, *needle, byte_start);
 
     if (found_pos == std::string::npos) {
         return 0.0; // Not found
     }
-    else {
-        return static_cast<double>(found_pos + 1); // Return 1-indexed position
+    if (!ascii) found_pos = StringUtils::utf8_length(std::string_view(*haystack).substr(0, found_pos));
+    return static_cast<double>(found_pos + 1); // Return 1-indexed position
+}
+
+namespace {
+    // Aho-Corasick automaton over a list of patterns, built as a dense transition table so
+    // a search takes one table lookup per byte of text, whatever the number of patterns.
+    class MultiMatcher {
+    public:
+        explicit MultiMatcher(const std::vector<std::string>& patterns) : patterns(patterns) {
+            add_state();
+            for (size_t p = 0; p < patterns.size(); ++p) {
+                const std::string& pattern = patterns[p];
+                if (pattern.empty()) continue; // An empty pattern never matches
+                int state = 0;
+                for (unsigned char c : pattern) {
+                    if (next[state * 256 + c] == 0) {
+                        const int child = add_state();
+                        next[state * 256 + c] = child;
+                    }
+                    state = next[state * 256 + c];
+                }
+                // Equal patterns report the first one in the list.
+                if (terminal[state] < 0) terminal[state] = static_cast<int>(p);
+                max_length = std::max(max_length, pattern.size());
+            }
+
+            // Breadth-first: fill in the missing transitions from the failure links and
+            // link every state to the patterns that end there (its output chain).
+            std::vector<int> queue;
+            std::vector<int> fail(terminal.size(), 0);
+            for (int c = 0; c < 256; ++c) {
+                if (next[c] != 0) queue.push_back(next[c]);
+            }
+            for (size_t head = 0; head < queue.size(); ++head) {
+                const int state = queue[head];
+                next_output[state] = output[fail[state]];
+                output[state] = terminal[state] >= 0 ? state : next_output[state];
+                for (int c = 0; c < 256; ++c) {
+                    int& target = next[state * 256 + c];
+                    const int fallback = next[fail[state] * 256 + c];
+                    if (target != 0) {
+                        fail[target] = fallback;
+                        queue.push_back(target);
+                    }
+                    else {
+                        target = fallback;
+                    }
+                }
+            }
+        }
+
+        const std::vector<std::string>& list() const { return patterns; }
+
+        // Finds the leftmost match in text, from byte 'from' on. Of the patterns starting
+        // there, the one listed first wins. Returns false if no pattern occurs.
+        bool search(std::string_view text, size_t from, size_t& match_pos, size_t& pattern) const {
+            size_t best_pos = std::string_view::npos;
+            size_t best_pattern = 0;
+            int state = 0;
+            for (size_t i = from; i < text.size(); ++i) {
+                // Once a match is known, only matches that start earlier could still win.
+                if (best_pos != std::string_view::npos && i >= best_pos + max_length) break;
+                state = next[state * 256 + static_cast<unsigned char>(text[i])];
+                for (int out = output[state]; out > 0; out = next_output[out]) {
+                    const size_t p = static_cast<size_t>(terminal[out]);
+                    const size_t start = i + 1 - patterns[p].size();
+                    if (start < best_pos || (start == best_pos && p < best_pattern)) {
+                        best_pos = start;
+                        best_pattern = p;
+                    }
+                }
+            }
+            if (best_pos == std::string_view::npos) return false;
+            match_pos = best_pos;
+            pattern = best_pattern;
+            return true;
+        }
+
+    private:
+        int add_state() {
+            next.resize(next.size() + 256, 0);
+            terminal.push_back(-1);
+            output.push_back(0);
+            next_output.push_back(0);
+            return static_cast<int>(terminal.size()) - 1;
+        }
+
+        std::vector<std::string> patterns;
+        std::vector<int> next;      // 256 transitions per state
+        std::vector<int> terminal;  // Pattern ending in each state, or -1
+        std::vector<int> output;    // Nearest state on the failure chain that ends a pattern (0 = none)
+        std::vector<int> next_output; // Next output state after this one on the failure chain
+        size_t max_length = 0;
+    };
+
+    // Scripts search the same keyword list over and over, so the last automaton is kept.
+    std::shared_ptr<MultiMatcher> last_matcher;
+}
+
+// INSTRANY(text$, patterns_array, [start]) -> array
+// Searches text$ for all patterns at once and returns [position, index]: the 1-based
+// position of the leftmost match and the 0-based index of the pattern found there
+// (the first listed one if several start at that position), or [0, -1] if none occurs.
+BasicValue builtin_instrany(NeReLaBasic& vm, const std::vector<BasicValue>& args) {
+    if (args.size() < 2 || args.size() > 3) {
+        Error::set(8, vm.runtime_current_line, "INSTRANY requires 2 or 3 arguments: text$, patterns_array, [start]");
+        return 0.0;
     }
+    const auto* list_ptr = std::get_if<std::shared_ptr<Array>>(&args[1]);
+    if (!list_ptr || !*list_ptr) {
+        Error::set(15, vm.runtime_current_line, "Second argument to INSTRANY must be an array of strings.");
+        return 0.0;
+    }
+
+    std::vector<std::string> patterns;
+    patterns.reserve((*list_ptr)->data.size());
+    for (const auto& item : (*list_ptr)->data) patterns.push_back(to_string(item));
+    if (!last_matcher || last_matcher->list() != patterns) {
+        last_matcher = std::make_shared<MultiMatcher>(patterns);
+    }
+
+    std::string text_copy;
+    const std::string* text = std::get_if<std::string>(&args[0]);
+    if (!text) { text_copy = to_string(args[0]); text = &text_copy; }
+
+    const bool ascii = StringUtils::is_ascii(*text);
+    size_t byte_start = 0;
+    if (args.size() == 3) {
+        const double start = to_double(args[2]);
+        byte_start = start > 1.0 ? char_offset(*text, ascii, static_cast<size_t>(start) - 1) : 0;
+    }
+
+    auto result = std::make_shared<Array>();
+    result->shape = { 2 };
+    size_t match_pos = 0, pattern = 0;
+    if (!last_matcher->search(*text, byte_start, match_pos, pattern)) {
+        result->data = { 0.0, -1.0 };
+        return result;
+    }
+    if (!ascii) match_pos = StringUtils::utf8_length(std::string_view(*text).substr(0, match_pos));
+    result->data = { static_cast<double>(match_pos + 1), static_cast<double>(pattern) };
+    return result;
 }
 // INKEY$()
 BasicValue builtin_inkey(NeReLaBasic& vm, const std::vector<BasicValue>& args) {
@@ -867,6 +1251,9 @@ BasicValue builtin_inkey(NeReLaBasic& vm, const std::vector<BasicValue>& args) {
         return std::string(""); // Return empty string on error
     }
 
+    // Programs that poll the keyboard are interactive, so show pending output first.
+    TextIO::flush();
+
     // _kbhit() checks if a key has been pressed without waiting.
     if (_kbhit()) {
         // A key is waiting in the buffer. _getch() reads it without echoing to screen.
@@ -879,21 +1266,26 @@ BasicValue builtin_inkey(NeReLaBasic& vm, const std::vector<BasicValue>& args) {
 }
 
 // VAL(string_expression) -> number
+// Given an array of strings, returns an array of numbers.
 BasicValue builtin_val(NeReLaBasic& vm, const std::vector<BasicValue>& args) {
     if (args.size() != 1) {
         Error::set(8, 0); // Wrong number of arguments
         return 0.0;
     }
-    std::string s = to_string(args[0]);
-    try {
-        // std::stod will parse the string until it finds a non-numeric character.
-        // This behavior is very similar to classic BASIC VAL().
-        return std::stod(s);
-    }
-    catch (const std::exception&) {
-        // If the string is not a valid number at all (e.g., "hello")
-        return 0.0;
-    }
+    // Like classic BASIC VAL(), the text is read up to the first character that cannot be
+    // part of the number; text that does not start with a number (e.g. "hello") gives 0.
+    const auto& punct = LocaleManager::get_number_punct();
+    auto val = [decimal_point = punct.decimal_point, thousands_sep = punct.thousands_sep](const BasicValue& v) -> BasicValue {
+        if (const auto* number = std::get_if<double>(&v)) return *number;
+        if (const auto* number = std::get_if<int>(&v)) return static_cast<double>(*number);
+        double value = 0.0;
+        if (const auto* text = std::get_if<std::string>(&v)) {
+            return StringUtils::parse_number(*text, value, decimal_point, thousands_sep) ? value : 0.0;
+        }
+        return StringUtils::parse_number(to_string(v), value, decimal_point, thousands_sep) ? value : 0.0;
+    };
+    if (const Array* arr = array_arg(args[0])) return map_elements(*arr, val);
+    return val(args[0]);
 }
 
 // STR$(numeric_expression) -> string
@@ -906,38 +1298,265 @@ BasicValue builtin_str_str(NeReLaBasic& vm, const std::vector<BasicValue>& args)
     return to_string(args[0]);
 }
 
-// SPLIT(source_string$, delimiter_string$) -> array
-// Splits a string into an array of substrings based on a delimiter.
+namespace {
+    // A pattern compiled for SPLIT and the REGEX.* functions. Patterns without any regex
+    // metacharacters are plain text and are searched for directly instead of with std::regex.
+    struct CompiledPattern {
+        bool is_literal = false;
+        std::string literal;
+        std::regex regex;
+    };
+
+    constexpr size_t REGEX_CACHE_SIZE = 64;
+
+    // Compiled patterns, most recently used first, so a pattern used inside a loop is
+    // compiled only once.
+    std::list<std::pair<std::string, std::shared_ptr<const CompiledPattern>>> regex_cache;
+    std::unordered_map<std::string, decltype(regex_cache)::iterator> regex_cache_index;
+
+    // Returns the compiled form of a pattern. Throws std::regex_error for invalid patterns.
+    std::shared_ptr<const CompiledPattern> get_compiled_pattern(const std::string& pattern) {
+        auto found = regex_cache_index.find(pattern);
+        if (found != regex_cache_index.end()) {
+            regex_cache.splice(regex_cache.begin(), regex_cache, found->second);
+            return found->second->second;
+        }
+
+        auto compiled = std::make_shared<CompiledPattern>();
+        compiled->regex = std::regex(pattern, std::regex::ECMAScript | std::regex::optimize);
+        if (!pattern.empty() && pattern.find_first_of("\\^$.|?*+()[]{}") == std::string::npos) {
+            compiled->is_literal = true;
+            compiled->literal = pattern;
+        }
+
+        regex_cache.emplace_front(pattern, compiled);
+        regex_cache_index[pattern] = regex_cache.begin();
+        if (regex_cache.size() > REGEX_CACHE_SIZE) {
+            regex_cache_index.erase(regex_cache.back().first);
+            regex_cache.pop_back();
+        }
+        return compiled;
+    }
+
+    // Collects the fields of 'source' separated by a literal delimiter. With max_parts > 0
+    // the last field holds the unsplit remainder.
+    void split_fields(std::string_view source, std::string_view delimiter, size_t max_parts, std::vector<std::string_view>& fields) {
+        if (max_parts == 1) {
+            fields.push_back(source);
+            return;
+        }
+        size_t start = 0;
+        auto add_field = [&](size_t end) {
+            fields.push_back(source.substr(start, end - start));
+            start = end + delimiter.size();
+            return max_parts == 0 || fields.size() + 1 < max_parts;
+            };
+
+        if (delimiter.size() == 1) {
+            // Single characters are located with memchr, which scans many bytes per step.
+            const char* base = source.data();
+            while (start < source.size()) {
+                const void* hit = std::memchr(base + start, delimiter[0], source.size() - start);
+                if (!hit) break;
+                if (!add_field(static_cast<const char*>(hit) - base)) break;
+            }
+        }
+        else {
+            // Longer delimiters use a Boyer-Moore-Horspool search that skips ahead by up to
+            // the delimiter length on every mismatch.
+            const std::boyer_moore_horspool_searcher searcher(delimiter.begin(), delimiter.end());
+            while (start <= source.size()) {
+                auto hit = std::search(source.begin() + start, source.end(), searcher);
+                if (hit == source.end()) break;
+                if (!add_field(hit - source.begin())) break;
+            }
+        }
+        fields.push_back(source.substr(std::min(start, source.size())));
+    }
+
+    // Collects the fields of 'source' separated by matches of a regular expression.
+    // Empty matches do not split.
+    void split_fields_regex(std::string_view source, const std::regex& delimiter, size_t max_parts, std::vector<std::string_view>& fields) {
+        size_t start = 0;
+        for (std::cregex_iterator it(source.data(), source.data() + source.size(), delimiter), end; it != end; ++it) {
+            if (max_parts > 0 && fields.size() + 1 >= max_parts) break;
+            if (it->length(0) == 0) continue;
+            const size_t pos = static_cast<size_t>(it->position(0));
+            fields.push_back(source.substr(start, pos - start));
+            start = pos + static_cast<size_t>(it->length(0));
+        }
+        fields.push_back(source.substr(start));
+    }
+
+    void split_fields_pattern(std::string_view source, const CompiledPattern& pattern, size_t max_parts, std::vector<std::string_view>& fields) {
+        if (pattern.is_literal) split_fields(source, pattern.literal, max_parts, fields);
+        else split_fields_regex(source, pattern.regex, max_parts, fields);
+    }
+
+    // Builds the result array, constructing every element string exactly once.
+    BasicValue fields_to_array(const std::vector<std::string_view>& fields) {
+        auto result_ptr = std::make_shared<Array>();
+        result_ptr->data.reserve(fields.size());
+        for (std::string_view field : fields) {
+            result_ptr->data.emplace_back(std::string(field));
+        }
+        result_ptr->shape = { result_ptr->data.size() };
+        return result_ptr;
+    }
+
+    // Compiles a pattern argument. Sets an error and returns nullptr if it is invalid.
+    std::shared_ptr<const CompiledPattern> compile_pattern_arg(NeReLaBasic& vm, const std::string& pattern) {
+        try {
+            return get_compiled_pattern(pattern);
+        }
+        catch (const std::regex_error& e) {
+            Error::set(1, vm.runtime_current_line, "Invalid regular expression: " + std::string(e.what()));
+            return nullptr;
+        }
+    }
+}
+
+// SPLIT(source_string$, delimiter_string$, [max_parts], [is_regex]) -> array
+// Splits a string into an array of substrings based on a delimiter. With max_parts > 0 at
+// most that many parts are returned, the last one holding the rest of the string.
+// With is_regex TRUE the delimiter is a regular expression.
 BasicValue builtin_split(NeReLaBasic& vm, const std::vector<BasicValue>& args) {
-    if (args.size() != 2) {
+    if (args.size() < 2 || args.size() > 4) {
         Error::set(8, vm.runtime_current_line);
         return {};
     }
 
-    std::string source = to_string(args[0]);
+    // A string argument is split in place; only other values are converted first.
+    std::string converted;
+    const std::string& source = std::holds_alternative<std::string>(args[0])
+        ? std::get<std::string>(args[0])
+        : (converted = to_string(args[0]));
     std::string delimiter = to_string(args[1]);
+    const double max_arg = (args.size() >= 3) ? to_double(args[2]) : 0.0;
+    const size_t max_parts = max_arg > 0 ? static_cast<size_t>(max_arg) : 0;
+    const bool is_regex = (args.size() >= 4) && to_bool(args[3]);
 
     if (delimiter.empty()) {
         Error::set(1, vm.runtime_current_line); // Cannot split by empty delimiter
         return {};
     }
 
-    auto result_ptr = std::make_shared<Array>();
-    size_t start = 0;
-    size_t end = source.find(delimiter);
+    // Find all fields first, so every element string is built exactly once.
+    std::vector<std::string_view> fields;
+    if (is_regex) {
+        auto pattern = compile_pattern_arg(vm, delimiter);
+        if (!pattern) return {};
+        split_fields_pattern(source, *pattern, max_parts, fields);
+    }
+    else {
+        split_fields(source, delimiter, max_parts, fields);
+    }
+    return fields_to_array(fields);
+}
+
+// REGEX.MATCH(text$, pattern$) -> boolean
+// Returns TRUE if the regular expression matches anywhere in text$ (anchor it with ^...$
+// to test the whole string).
+BasicValue builtin_regex_match(NeReLaBasic& vm, const std::vector<BasicValue>& args) {
+    if (args.size() != 2) {
+        Error::set(8, vm.runtime_current_line);
+        return false;
+    }
+    std::string text = to_string(args[0]);
+    auto pattern = compile_pattern_arg(vm, to_string(args[1]));
+    if (!pattern) return false;
+
+    if (pattern->is_literal) {
+        return text.find(pattern->literal) != std::string::npos;
+    }
+    return std::regex_search(text, pattern->regex);
+}
 
-    while (end != std::string::npos) {
-        result_ptr->data.push_back(source.substr(start, end - start));
-        start = end + delimiter.length();
-        end = source.find(delimiter, start);
+// REGEX.FIND(text$, pattern$) -> array
+// Returns the first match as an array: the matched text followed by the text of each
+// capture group. Returns an empty array if there is no match.
+BasicValue builtin_regex_find(NeReLaBasic& vm, const std::vector<BasicValue>& args) {
+    if (args.size() != 2) {
+        Error::set(8, vm.runtime_current_line);
+        return {};
     }
-    // Add the last token
-    result_ptr->data.push_back(source.substr(start, end));
+    std::string text = to_string(args[0]);
+    auto pattern = compile_pattern_arg(vm, to_string(args[1]));
+    if (!pattern) return {};
 
+    auto result_ptr = std::make_shared<Array>();
+    if (pattern->is_literal) {
+        if (text.find(pattern->literal) != std::string::npos) {
+            result_ptr->data.push_back(pattern->literal);
+        }
+    }
+    else {
+        std::smatch match;
+        if (std::regex_search(text, match, pattern->regex)) {
+            for (const auto& group : match) {
+                result_ptr->data.push_back(group.str());
+            }
+        }
+    }
     result_ptr->shape = { result_ptr->data.size() };
     return result_ptr;
 }
 
+// REGEX.REPLACE$(text$, pattern$, replacement$) -> string$
+// Replaces every match. The replacement may refer to the match as $& and to groups as $1, $2, ...
+BasicValue builtin_regex_replace_str(NeReLaBasic& vm, const std::vector<BasicValue>& args) {
+    if (args.size() != 3) {
+        Error::set(8, vm.runtime_current_line);
+        return std::string("");
+    }
+    std::string text = to_string(args[0]);
+    std::string replacement = to_string(args[2]);
+    auto pattern = compile_pattern_arg(vm, to_string(args[1]));
+    if (!pattern) return std::string("");
+
+    if (pattern->is_literal && replacement.find('$') == std::string::npos) {
+        std::string result;
+        result.reserve(text.size());
+        size_t start = 0;
+        for (size_t hit = text.find(pattern->literal); hit != std::string::npos; hit = text.find(pattern->literal, start)) {
+            result.append(text, start, hit - start);
+            result += replacement;
+            start = hit + pattern->literal.size();
+        }
+        result.append(text, start, std::string::npos);
+        return result;
+    }
+    return std::regex_replace(text, pattern->regex, replacement);
+}
+
+// REGEX.SPLIT(text$, pattern$, [max_parts]) -> array
+// Splits a string at every match of a regular expression (same as SPLIT with is_regex TRUE).
+BasicValue builtin_regex_split(NeReLaBasic& vm, const std::vector<BasicValue>& args) {
+    if (args.size() < 2 || args.size() > 3) {
+        Error::set(8, vm.runtime_current_line);
+        return {};
+    }
+    std::string text = to_string(args[0]);
+    auto pattern = compile_pattern_arg(vm, to_string(args[1]));
+    if (!pattern) return {};
+    const double max_arg = (args.size() == 3) ? to_double(args[2]) : 0.0;
+
+    std::vector<std::string_view> fields;
+    split_fields_pattern(text, *pattern, max_arg > 0 ? static_cast<size_t>(max_arg) : 0, fields);
+    return fields_to_array(fields);
+}
+
+namespace {
+    // Appends the text of a value as to_string() shows it; numbers are written straight
+    // into 'out' without a temporary string.
+    void append_value_text(std::string& out, const BasicValue& value) {
+        if (const double* d = std::get_if<double>(&value)) LocaleManager::append_number(out, *d);
+        else if (const int* i = std::get_if<int>(&value)) LocaleManager::append_number(out, static_cast<long long>(*i));
+        else if (const std::string* text = std::get_if<std::string>(&value)) out += *text;
+        else out += to_string(value);
+    }
+}
+
 // FRMV$(array) -> string$
 // Formats a 1D or 2D array into a right-aligned string matrix.
 BasicValue builtin_frmv_str(NeReLaBasic& vm, const std::vector<BasicValue>& args) {
@@ -974,153 +1593,347 @@ BasicValue builtin_frmv_str(NeReLaBasic& vm, const std::vector<BasicValue>& args
         return std::string(""); // No columns to format
     }
 
-    // 3. Calculate Maximum Width for Each Column
+    // 3. Format every cell once into a single buffer, tracking the column widths
+    const size_t cells = rows * cols;
+    std::string text;
+    std::vector<size_t> cell_end(cells);
     std::vector<size_t> col_widths(cols, 0);
-    for (size_t r = 0; r < rows; ++r) {
-        for (size_t c = 0; c < cols; ++c) {
-            std::string val_str = to_string(arr_ptr->data[r * cols + c]);
-            if (val_str.length() > col_widths[c]) {
-                col_widths[c] = val_str.length();
-            }
-        }
+    for (size_t i = 0; i < cells; ++i) {
+        const size_t begin = text.size();
+        append_value_text(text, arr_ptr->data[i]);
+        cell_end[i] = text.size();
+        col_widths[i % cols] = std::max(col_widths[i % cols], cell_end[i] - begin);
     }
 
     // 4. Build the Formatted String
-    std::stringstream ss;
+    size_t row_width = cols - 1;
+    for (size_t width : col_widths) row_width += width;
+    std::string result;
+    result.reserve(rows * (row_width + 1));
     for (size_t r = 0; r < rows; ++r) {
         for (size_t c = 0; c < cols; ++c) {
-            ss << std::right << std::setw(col_widths[c]) << to_string(arr_ptr->data[r * cols + c]);
+            const size_t i = r * cols + c;
+            const size_t begin = (i == 0) ? 0 : cell_end[i - 1];
+            result.append(col_widths[c] - (cell_end[i] - begin), ' ');
+            result.append(text, begin, cell_end[i] - begin);
             if (c < cols - 1) {
-                ss << " "; // Separator between columns
+                result += ' '; // Separator between columns
             }
         }
         if (r < rows - 1) {
-            ss << "\n"; // Newline for the next row
+            result += '\n'; // Newline for the next row
         }
     }
 
-    return ss.str();
+    return result;
 }
 
-// In BuiltinFunctions.cpp
-
-// Replace the existing builtin_format_str with this corrected version.
-
-// FORMAT$(format_string$, arg1, arg2, ...) -> string$
-// Formats a string using C++20-style format specifiers.
-BasicValue builtin_format_str(NeReLaBasic& vm, const std::vector<BasicValue>& args) {
-    // 1. Argument Validation
-    if (args.empty()) {
-        Error::set(8, vm.runtime_current_line); // Wrong number of arguments
-        return std::string("");
-    }
-
-    std::string format_string = to_string(args[0]);
-    std::vector<BasicValue> format_args;
-    if (args.size() > 1) {
-        format_args.assign(args.begin() + 1, args.end());
-    }
-
-    std::stringstream result;
-    size_t last_pos = 0;
-    size_t auto_index = 0;
+namespace {
+    // One piece of a compiled FORMAT$ pattern: literal text or a {index:spec} placeholder.
+    struct FormatOp {
+        bool is_literal = true;
+        std::string text;          // Literal text, or the placeholder as written (shown if there is no argument)
+        size_t arg_index = 0;
+        std::string spec = "{}";   // The placeholder as a std::format string
+        char type = 0;             // Presentation type, the last character of the spec
+        // Specs of the form [width][.precision][type] are formatted with to_chars.
+        bool simple = false;
+        size_t width = 0;
+        int precision = -1;
+    };
 
-    // Manually iterate through the format string to handle each placeholder
-    while (last_pos < format_string.length()) {
-        size_t brace_pos = format_string.find('{', last_pos);
+    struct CompiledFormat {
+        std::vector<FormatOp> ops;
+    };
 
-        if (brace_pos == std::string::npos) {
-            result << format_string.substr(last_pos);
-            break;
+    constexpr size_t FORMAT_CACHE_SIZE = 64;
+
+    // Compiled patterns, most recently used first, so a FORMAT$ call inside a loop parses
+    // its pattern only once.
+    std::list<std::pair<std::string, std::shared_ptr<const CompiledFormat>>> format_cache;
+    std::unordered_map<std::string, decltype(format_cache)::iterator> format_cache_index;
+
+    // Parses the part of a spec after ':' if it only has a width, a precision and a
+    // presentation type for which to_chars gives the same result as std::format.
+    bool parse_simple_spec(std::string_view spec, FormatOp& op) {
+        size_t i = 0;
+        if (i < spec.size() && spec[i] >= '1' && spec[i] <= '9') {
+            auto [ptr, ec] = std::from_chars(spec.data(), spec.data() + spec.size(), op.width);
+            if (ec != std::errc()) return false;
+            i = static_cast<size_t>(ptr - spec.data());
         }
-
-        result << format_string.substr(last_pos, brace_pos - last_pos);
-
-        if (brace_pos + 1 < format_string.length() && format_string[brace_pos + 1] == '{') {
-            result << '{';
-            last_pos = brace_pos + 2;
-            continue;
+        if (i < spec.size() && spec[i] == '.') {
+            auto [ptr, ec] = std::from_chars(spec.data() + i + 1, spec.data() + spec.size(), op.precision);
+            if (ec != std::errc() || op.precision > 100) return false;
+            i = static_cast<size_t>(ptr - spec.data());
         }
+        if (i < spec.size() && std::string_view("defg").find(spec[i]) != std::string_view::npos) ++i;
+        return i == spec.size();
+    }
 
-        size_t end_brace = format_string.find('}', brace_pos + 1);
-        if (end_brace == std::string::npos) {
-            result << format_string.substr(brace_pos);
-            break;
-        }
+    std::shared_ptr<const CompiledFormat> compile_format(const std::string& pattern) {
+        auto compiled = std::make_shared<CompiledFormat>();
+        auto& ops = compiled->ops;
+        auto add_literal = [&ops](std::string_view text) {
+            if (text.empty()) return;
+            if (ops.empty() || !ops.back().is_literal) ops.emplace_back();
+            ops.back().text += text;
+        };
 
-        std::string spec_content = format_string.substr(brace_pos + 1, end_brace - (brace_pos + 1));
-        size_t arg_index;
-        std::string format_specifier = "{}";
+        size_t last_pos = 0;
+        size_t auto_index = 0;
+        while (last_pos < pattern.length()) {
+            size_t brace_pos = pattern.find('{', last_pos);
+            if (brace_pos == std::string::npos) {
+                add_literal(std::string_view(pattern).substr(last_pos));
+                break;
+            }
+            add_literal(std::string_view(pattern).substr(last_pos, brace_pos - last_pos));
 
-        size_t colon_pos = spec_content.find(':');
-        std::string index_str = spec_content;
+            if (brace_pos + 1 < pattern.length() && pattern[brace_pos + 1] == '{') {
+                add_literal("{");
+                last_pos = brace_pos + 2;
+                continue;
+            }
+            size_t end_brace = pattern.find('}', brace_pos + 1);
+            if (end_brace == std::string::npos) {
+                add_literal(std::string_view(pattern).substr(brace_pos));
+                break;
+            }
+            last_pos = end_brace + 1;
+
+            std::string spec_content = pattern.substr(brace_pos + 1, end_brace - (brace_pos + 1));
+            FormatOp op;
+            op.is_literal = false;
+            op.text = "{" + spec_content + "}";
+
+            std::string index_str = spec_content;
+            size_t colon_pos = spec_content.find(':');
+            if (colon_pos != std::string::npos) {
+                index_str = spec_content.substr(0, colon_pos);
+                op.spec = "{:" + spec_content.substr(colon_pos + 1) + "}";
+                op.type = op.spec[op.spec.size() - 2];
+                op.simple = parse_simple_spec(std::string_view(spec_content).substr(colon_pos + 1), op);
+            }
+            else {
+                op.simple = true;
+            }
 
-        if (colon_pos != std::string::npos) {
-            index_str = spec_content.substr(0, colon_pos);
-            format_specifier = "{:" + spec_content.substr(colon_pos + 1) + "}";
+            if (index_str.empty()) {
+                op.arg_index = auto_index++;
+            }
+            else {
+                try {
+                    op.arg_index = std::stoul(index_str);
+                }
+                catch (const std::exception&) {
+                    add_literal(op.text);
+                    continue;
+                }
+            }
+            ops.push_back(std::move(op));
         }
+        return compiled;
+    }
 
-        if (index_str.empty()) {
-            arg_index = auto_index++;
+    std::shared_ptr<const CompiledFormat> get_compiled_format(const std::string& pattern) {
+        auto found = format_cache_index.find(pattern);
+        if (found != format_cache_index.end()) {
+            format_cache.splice(format_cache.begin(), format_cache, found->second);
+            return found->second->second;
         }
-        else {
-            try {
-                arg_index = std::stoul(index_str);
-            }
-            catch (const std::exception&) {
-                result << "{" << spec_content << "}";
-                last_pos = end_brace + 1;
-                continue;
-            }
+
+        auto compiled = compile_format(pattern);
+        format_cache.emplace_front(pattern, compiled);
+        format_cache_index[pattern] = format_cache.begin();
+        if (format_cache.size() > FORMAT_CACHE_SIZE) {
+            format_cache_index.erase(format_cache.back().first);
+            format_cache.pop_back();
         }
+        return compiled;
+    }
+
+    // Appends the to_chars result right-aligned in op.width, like std::format does for numbers.
+    template <typename... Options>
+    bool append_chars(std::string& out, const FormatOp& op, Options... options) {
+        char buffer[512];
+        auto [ptr, ec] = std::to_chars(buffer, buffer + sizeof(buffer), options...);
+        if (ec != std::errc()) return false;
+        const size_t length = static_cast<size_t>(ptr - buffer);
+        if (op.width > length) out.append(op.width - length, ' ');
+        out.append(buffer, length);
+        return true;
+    }
 
-        if (arg_index < format_args.size()) {
-            const BasicValue& arg = format_args[arg_index];
-            try {
-                result << std::visit([&](auto&& value) -> std::string {
-                    using T = std::decay_t<decltype(value)>;
-
-                    // --- START OF THE FIX ---
-                    if constexpr (std::is_same_v<T, double>) {
-                        // Check the format specifier to see if an integer type is requested.
-                        size_t spec_end_pos = format_specifier.length() - 1;
-                        if (spec_end_pos > 0 && format_specifier[spec_end_pos] == '}') {
-                            char type_char = format_specifier[spec_end_pos - 1];
-                            // Check for integer-only types: d, x, X, b, B, o, c
-                            if (std::string("dxXbo").find(type_char) != std::string::npos) {
-                                // It's an integer format. Cast the double to a long long.
-                                return std::vformat(format_specifier, std::make_format_args(static_cast<long long>(value)));
-                            }
-                            if (type_char == 'c') {
-                                // Handle character case
-                                return std::vformat(format_specifier, std::make_format_args(static_cast<char>(static_cast<long long>(value))));
-                            }
-                        }
-                        // If it's not an integer type, format as a double.
-                        return std::vformat(format_specifier, std::make_format_args(value));
-                    }
-                    // --- END OF THE FIX ---
+    // Formats a number through the to_chars fast path. Returns false if the spec needs std::format.
+    bool append_simple_number(std::string& out, const FormatOp& op, double value) {
+        if (!op.simple) return false;
+        switch (op.type) {
+        case 'd': return op.precision < 0 && append_chars(out, op, static_cast<long long>(value));
+        case 'f': return append_chars(out, op, value, std::chars_format::fixed, op.precision < 0 ? 6 : op.precision);
+        case 'e': return append_chars(out, op, value, std::chars_format::scientific, op.precision < 0 ? 6 : op.precision);
+        case 'g': return append_chars(out, op, value, std::chars_format::general, op.precision < 0 ? 6 : op.precision);
+        default:
+            if (op.precision < 0) return append_chars(out, op, value);
+            return append_chars(out, op, value, std::chars_format::general, op.precision);
+        }
+    }
+
+    void append_formatted(std::string& out, const FormatOp& op, const BasicValue& arg) {
+        try {
+            std::visit([&](auto&& value) {
+                using T = std::decay_t<decltype(value)>;
 
-                    else if constexpr (std::is_same_v<T, bool> || std::is_same_v<T, int> || std::is_same_v<T, std::string>) {
-                        // These types are fine as they are
-                        return std::vformat(format_specifier, std::make_format_args(value));
+                if constexpr (std::is_same_v<T, double>) {
+                    if (append_simple_number(out, op, value)) return;
+                    // Integer-only types: d, x, X, b, o, and c for a character.
+                    if (std::string_view("dxXbo").find(op.type) != std::string_view::npos) {
+                        out += std::vformat(op.spec, std::make_format_args(static_cast<long long>(value)));
+                    }
+                    else if (op.type == 'c') {
+                        out += std::vformat(op.spec, std::make_format_args(static_cast<char>(static_cast<long long>(value))));
                     }
                     else {
-                        // Fallback for complex types (Array, Map, etc.)
-                        return to_string(value);
+                        out += std::vformat(op.spec, std::make_format_args(value));
                     }
-                    }, arg);
-            }
-            catch (const std::format_error& e) {
-                result << "{FORMAT ERROR: " << e.what() << "}";
-            }
+                }
+                else if constexpr (std::is_same_v<T, std::string>) {
+                    if (op.spec == "{}") out += value;
+                    else out += std::vformat(op.spec, std::make_format_args(value));
+                }
+                else if constexpr (std::is_same_v<T, int>) {
+                    if (op.simple && (op.type == 0 || op.type == 'd') && op.precision < 0 && append_chars(out, op, value)) return;
+                    out += std::vformat(op.spec, std::make_format_args(value));
+                }
+                else if constexpr (std::is_same_v<T, bool>) {
+                    out += std::vformat(op.spec, std::make_format_args(value));
+                }
+                else {
+                    // Fallback for complex types (Array, Map, etc.)
+                    out += to_string(value);
+                }
+                }, arg);
+        }
+        catch (const std::format_error& e) {
+            out += "{FORMAT ERROR: ";
+            out += e.what();
+            out += "}";
+        }
+    }
+}
+
+// FORMAT$(format_string$, arg1, arg2, ...) -> string$
+// Formats a string using C++20-style format specifiers. The pattern is compiled once and
+// cached; numbers with plain width/precision specs are written with to_chars.
+BasicValue builtin_format_str(NeReLaBasic& vm, const std::vector<BasicValue>& args) {
+    // 1. Argument Validation
+    if (args.empty()) {
+        Error::set(8, vm.runtime_current_line); // Wrong number of arguments
+        return std::string("");
+    }
+
+    const auto compiled = get_compiled_format(to_string(args[0]));
+    const size_t arg_count = args.size() - 1;
+
+    std::string result;
+    for (const FormatOp& op : compiled->ops) {
+        if (op.is_literal || op.arg_index >= arg_count) {
+            result += op.text;
         }
         else {
-            result << "{" << spec_content << "}";
+            append_formatted(result, op, args[op.arg_index + 1]);
         }
-        last_pos = end_brace + 1;
     }
-    return result.str();
+    return result;
+}
+
+// --- String Builders ---
+
+// Looks up the buffer behind a string builder handle. Sets an error if there is none.
+static std::string* get_string_builder(NeReLaBasic& vm, const BasicValue& handle) {
+    auto it = vm.string_builders.find(static_cast<int>(to_double(handle)));
+    if (it == vm.string_builders.end()) {
+        Error::set(3, vm.runtime_current_line, "String builder not found.");
+        return nullptr;
+    }
+    return &it->second;
+}
+
+// STRINGBUILDER([initial$]) -> handle
+// Creates a growable text buffer for building long strings piece by piece.
+BasicValue builtin_stringbuilder(NeReLaBasic& vm, const std::vector<BasicValue>& args) {
+    if (args.size() > 1) {
+        Error::set(8, vm.runtime_current_line);
+        return 0.0;
+    }
+    int handle = vm.next_string_builder++;
+    std::string& buffer = vm.string_builders[handle];
+    if (!args.empty()) buffer = to_string(args[0]);
+    return static_cast<double>(handle);
+}
+
+// SB.APPEND handle, value1, [value2, ...]
+// Appends the values to the end of the buffer.
+BasicValue builtin_sb_append(NeReLaBasic& vm, const std::vector<BasicValue>& args) {
+    if (args.size() < 2) {
+        Error::set(8, vm.runtime_current_line);
+        return false;
+    }
+    std::string* buffer = get_string_builder(vm, args[0]);
+    if (!buffer) return false;
+    for (size_t i = 1; i < args.size(); ++i) {
+        if (const auto* text = std::get_if<std::string>(&args[i])) *buffer += *text;
+        else *buffer += to_string(args[i]);
+    }
+    return false;
+}
+
+// SB.TOSTRING$(handle) -> string$
+// Returns the text built so far.
+BasicValue builtin_sb_tostring_str(NeReLaBasic& vm, const std::vector<BasicValue>& args) {
+    if (args.size() != 1) {
+        Error::set(8, vm.runtime_current_line);
+        return std::string("");
+    }
+    std::string* buffer = get_string_builder(vm, args[0]);
+    if (!buffer) return std::string("");
+    return *buffer;
+}
+
+// SB.LEN(handle) -> number
+// Returns the length of the text built so far.
+BasicValue builtin_sb_len(NeReLaBasic& vm, const std::vector<BasicValue>& args) {
+    if (args.size() != 1) {
+        Error::set(8, vm.runtime_current_line);
+        return 0.0;
+    }
+    std::string* buffer = get_string_builder(vm, args[0]);
+    if (!buffer) return 0.0;
+    return static_cast<double>(buffer->size());
+}
+
+// SB.CLEAR handle
+// Empties the buffer but keeps its capacity for reuse.
+BasicValue builtin_sb_clear(NeReLaBasic& vm, const std::vector<BasicValue>& args) {
+    if (args.size() != 1) {
+        Error::set(8, vm.runtime_current_line);
+        return false;
+    }
+    std::string* buffer = get_string_builder(vm, args[0]);
+    if (buffer) buffer->clear();
+    return false;
+}
+
+// SB.FREE handle
+// Releases a string builder.
+BasicValue builtin_sb_free(NeReLaBasic& vm, const std::vector<BasicValue>& args) {
+    if (args.size() != 1) {
+        Error::set(8, vm.runtime_current_line);
+        return false;
+    }
+    if (!get_string_builder(vm, args[0])) return false;
+    vm.string_builders.erase(static_cast<int>(to_double(args[0])));
+    return false;
 }
 
 // --- Vector and Matrix functions
@@ -1427,6 +2240,356 @@ BasicValue builtin_all(NeReLaBasic& vm, const std::vector<BasicValue>& args) {
     return result_ptr;
 }
 
+// --- Scan (Prefix) Functions ---
+
+namespace {
+    // Flat arrays at least this large are scanned in parallel blocks.
+    constexpr size_t PARALLEL_SCAN_THRESHOLD = 1 << 16;
+
+    // Operators with a native (non-BASIC) scan kernel.
+    enum class ScanOp { Plus, Times, Min, Max };
+
+    bool parse_scan_op(const std::string& op, ScanOp& out) {
+        if (op == "+") out = ScanOp::Plus;
+        else if (op == "*") out = ScanOp::Times;
+        else if (op == "MIN") out = ScanOp::Min;
+        else if (op == "MAX") out = ScanOp::Max;
+        else return false;
+        return true;
+    }
+
+    // Inclusive in-place scan of n contiguous values.
+    template <typename Op>
+    void scan_serial(double* first, size_t n, Op op) {
+        for (size_t i = 1; i < n; ++i) first[i] = op(first[i - 1], first[i]);
+    }
+
+    // Two-pass blocked parallel prefix scan: every thread scans its own block, the block
+    // totals are combined serially into carries, then every block but the first is offset
+    // by its carry. Falls back to the serial scan for small inputs.
+    template <typename Op>
+    void scan_parallel(std::vector<double>& v, Op op) {
+        const size_t n = v.size();
+        const size_t workers = worker_count(n, PARALLEL_SCAN_THRESHOLD / 4);
+        if (n < PARALLEL_SCAN_THRESHOLD || workers < 2) {
+            scan_serial(v.data(), n, op);
+            return;
+        }
+
+        run_blocks(n, workers, [&](size_t, size_t begin, size_t end) { scan_serial(v.data() + begin, end - begin, op); });
+
+        const size_t block = (n + workers - 1) / workers;
+        std::vector<double> carry(workers, 0.0);
+        for (size_t w = 1; w < workers; ++w) {
+            size_t prev_last = std::min(n, w * block) - 1;
+            carry[w] = (w == 1) ? v[prev_last] : op(carry[w - 1], v[prev_last]);
+        }
+
+        run_blocks(n, workers, [&](size_t w, size_t begin, size_t end) {
+            if (w == 0) return;
+            const double c = carry[w];
+            for (size_t i = begin; i < end; ++i) v[i] = op(c, v[i]);
+            });
+    }
+
+    // Runs an inclusive scan over 'data' laid out as rows x cols.
+    // dimension -1 scans the flat data, 0 runs down each column, 1 runs across each row.
+    // 'combine' returns false to abort (e.g. on an error inside a BASIC function).
+    template <typename T, typename Combine>
+    bool scan_sweep(std::vector<T>& data, size_t rows, size_t cols, int dimension, Combine combine) {
+        if (dimension == 0) {
+            for (size_t r = 1; r < rows; ++r)
+                for (size_t c = 0; c < cols; ++c)
+                    if (!combine(data[(r - 1) * cols + c], data[r * cols + c])) return false;
+        }
+        else if (dimension == 1) {
+            for (size_t r = 0; r < rows; ++r)
+                for (size_t c = 1; c < cols; ++c)
+                    if (!combine(data[r * cols + c - 1], data[r * cols + c])) return false;
+        }
+        else {
+            for (size_t i = 1; i < data.size(); ++i)
+                if (!combine(data[i - 1], data[i])) return false;
+        }
+        return true;
+    }
+
+    template <typename F>
+    void dispatch_scan_op(ScanOp op, F&& f) {
+        switch (op) {
+        case ScanOp::Plus:  f([](double a, double b) { return a + b; }); break;
+        case ScanOp::Times: f([](double a, double b) { return a * b; }); break;
+        case ScanOp::Min:   f([](double a, double b) { return std::min(a, b); }); break;
+        case ScanOp::Max:   f([](double a, double b) { return std::max(a, b); }); break;
+        }
+    }
+}
+
+// SCAN(array, op$ or funcref, [dimension]) -> array
+// Cumulative version of a reduction: each element holds the reduction of all elements up to it.
+// op$ is "+", "*", "MIN" or "MAX"; a function reference must accept two arguments.
+// Dimension is 0 to scan down each column and 1 to scan across each row of a 2D matrix.
+BasicValue builtin_scan(NeReLaBasic& vm, const std::vector<BasicValue>& args) {
+    // 1. --- Argument Validation ---
+    if (args.size() < 2 || args.size() > 3) {
+        Error::set(8, vm.runtime_current_line, "SCAN requires 2 or 3 arguments: array, operator, [dimension]");
+        return {};
+    }
+    if (!std::holds_alternative<std::shared_ptr<Array>>(args[0])) {
+        Error::set(15, vm.runtime_current_line, "First argument to SCAN must be an array.");
+        return {};
+    }
+    const auto& arr_ptr = std::get<std::shared_ptr<Array>>(args[0]);
+    if (!arr_ptr) return {};
+
+    int dimension = -1;
+    size_t rows = 1;
+    size_t cols = arr_ptr->data.size();
+    if (args.size() == 3) {
+        if (arr_ptr->shape.size() != 2) {
+            Error::set(15, vm.runtime_current_line, "Dimensional scan currently only supports 2D matrices.");
+            return {};
+        }
+        dimension = static_cast<int>(to_double(args[2]));
+        if (dimension != 0 && dimension != 1) {
+            Error::set(1, vm.runtime_current_line, "Invalid dimension for scan. Must be 0 or 1.");
+            return {};
+        }
+        rows = arr_ptr->shape[0];
+        cols = arr_ptr->shape[1];
+    }
+
+    auto result_ptr = std::make_shared<Array>();
+    result_ptr->shape = arr_ptr->shape;
+    const BasicValue& op_arg = args[1];
+
+    // 2. --- Native operators: scan on a plain double buffer ---
+    if (std::holds_alternative<std::string>(op_arg)) {
+        const std::string op_str = to_upper(std::get<std::string>(op_arg));
+        ScanOp op;
+        if (!parse_scan_op(op_str, op)) {
+            Error::set(1, vm.runtime_current_line, "Invalid operator string for SCAN: " + op_str);
+            return {};
+        }
+
+        std::vector<double> values;
+        values.reserve(arr_ptr->data.size());
+        for (const auto& val : arr_ptr->data) values.push_back(to_double(val));
+
+        dispatch_scan_op(op, [&](auto kernel) {
+            if (dimension == -1) {
+                scan_parallel(values, kernel);
+            }
+            else {
+                scan_sweep(values, rows, cols, dimension, [&](const double& prev, double& cur) { cur = kernel(prev, cur); return true; });
+            }
+            });
+
+        result_ptr->data.assign(values.begin(), values.end());
+        return result_ptr;
+    }
+
+    // 3. --- Generic path: call the BASIC function for every step ---
+    if (std::holds_alternative<FunctionRef>(op_arg)) {
+        const std::string func_name = to_upper(std::get<FunctionRef>(op_arg).name);
+        if (!vm.active_function_table->count(func_name)) {
+            Error::set(22, vm.runtime_current_line, "Operator function '" + func_name + "' not found.");
+            return {};
+        }
+        const auto& func_info = vm.active_function_table->at(func_name);
+        if (func_info.arity != 2) {
+            Error::set(26, vm.runtime_current_line, "Operator function '" + func_name + "' must accept exactly two arguments.");
+            return {};
+        }
+
+        result_ptr->data = arr_ptr->data;
+        bool ok = scan_sweep(result_ptr->data, rows, cols, dimension, [&](const BasicValue& prev, BasicValue& cur) {
+            std::vector<BasicValue> func_args = { prev, cur };
+            cur = vm.execute_function_for_value(func_info, func_args);
+            return Error::get() == 0; // Propagate error from user function
+            });
+        if (!ok) return {};
+        return result_ptr;
+    }
+
+    Error::set(15, vm.runtime_current_line, "Second argument to SCAN must be an operator string or a function reference.");
+    return {};
+}
+
+// --- Higher-Order Array Functions ---
+
+namespace {
+    // Arrays at least this large are processed by native kernels in parallel.
+    constexpr size_t PARALLEL_APPLY_THRESHOLD = 1 << 14;
+
+    // Built-in functions that are pure functions of one number. A reference to one of
+    // these (e.g. SQR@) runs as a tight native loop instead of one call per element.
+    using UnaryKernel = double(*)(double);
+    const std::unordered_map<std::string, UnaryKernel> NATIVE_UNARY_KERNELS = {
+        {"SIN", [](double x) { return std::sin(x); }},
+        {"COS", [](double x) { return std::cos(x); }},
+        {"TAN", [](double x) { return std::tan(x); }},
+        {"SQR", [](double x) { return (x < 0) ? 0.0 : std::sqrt(x); }} // Same rule as builtin_sqr
+    };
+
+    // The same for two numbers, used by REDUCE (e.g. MAX@).
+    using BinaryKernel = double(*)(double, double);
+    const std::unordered_map<std::string, BinaryKernel> NATIVE_BINARY_KERNELS = {
+        {"MIN", [](double a, double b) { return std::min(a, b); }},
+        {"MAX", [](double a, double b) { return std::max(a, b); }}
+    };
+
+    // Looks up the function behind a FunctionRef argument and checks that it can be called
+    // with 'arity' arguments. Sets an error and returns nullptr on failure.
+    const NeReLaBasic::FunctionInfo* resolve_function_ref(NeReLaBasic& vm, const BasicValue& ref, int arity, const std::string& caller) {
+        if (!std::holds_alternative<FunctionRef>(ref)) {
+            Error::set(15, vm.runtime_current_line, caller + " requires a function reference (e.g., myfunc@).");
+            return nullptr;
+        }
+        const std::string func_name = to_upper(std::get<FunctionRef>(ref).name);
+        if (!vm.active_function_table->count(func_name)) {
+            Error::set(22, vm.runtime_current_line, "Function '" + func_name + "' not found.");
+            return nullptr;
+        }
+        const auto& func_info = vm.active_function_table->at(func_name);
+        // A variadic builtin qualifies only if it has a native kernel for this arity (MIN@, MAX@).
+        const bool native_kernel = func_info.native_impl && func_info.arity == -1 &&
+            ((arity == 1 && NATIVE_UNARY_KERNELS.count(func_name)) || (arity == 2 && NATIVE_BINARY_KERNELS.count(func_name)));
+        if (func_info.arity != arity && !native_kernel) {
+            Error::set(26, vm.runtime_current_line, "Function '" + func_name + "' must accept exactly " + std::to_string(arity) + " argument(s).");
+            return nullptr;
+        }
+        return &func_info;
+    }
+
+    // Evaluates a one-argument function for every element of 'src' into 'out'.
+    // Native math kernels run in parallel blocks; everything else goes through the VM.
+    bool apply_unary(NeReLaBasic& vm, const NeReLaBasic::FunctionInfo& func_info, const std::vector<BasicValue>& src, std::vector<BasicValue>& out) {
+        out.resize(src.size());
+
+        auto kernel_it = NATIVE_UNARY_KERNELS.find(to_upper(func_info.name));
+        if (func_info.native_impl && kernel_it != NATIVE_UNARY_KERNELS.end()) {
+            const UnaryKernel kernel = kernel_it->second;
+            size_t workers = src.size() < PARALLEL_APPLY_THRESHOLD ? 1 : worker_count(src.size(), PARALLEL_APPLY_THRESHOLD / 4);
+            run_blocks(src.size(), workers, [&](size_t, size_t begin, size_t end) {
+                for (size_t i = begin; i < end; ++i) out[i] = kernel(to_double(src[i]));
+                });
+            return true;
+        }
+
+        // User functions run one at a time: the VM keeps a single call stack and
+        // program counter, so BASIC code cannot be evaluated from several threads.
+        std::vector<BasicValue> func_args(1);
+        for (size_t i = 0; i < src.size(); ++i) {
+            func_args[0] = src[i];
+            out[i] = vm.execute_function_for_value(func_info, func_args);
+            if (Error::get() != 0) return false; // Propagate error from user function
+        }
+        return true;
+    }
+}
+
+// APPLY(array, function@) -> array
+// Calls a one-argument function for every element and returns the results in an array of the same shape.
+BasicValue builtin_apply(NeReLaBasic& vm, const std::vector<BasicValue>& args) {
+    if (args.size() != 2) {
+        Error::set(8, vm.runtime_current_line, "APPLY requires 2 arguments: array, function_ref");
+        return {};
+    }
+    if (!std::holds_alternative<std::shared_ptr<Array>>(args[0])) {
+        Error::set(15, vm.runtime_current_line, "First argument to APPLY must be an array.");
+        return {};
+    }
+    const auto& arr_ptr = std::get<std::shared_ptr<Array>>(args[0]);
+    if (!arr_ptr) return {};
+    const auto* func_info = resolve_function_ref(vm, args[1], 1, "APPLY");
+    if (!func_info) return {};
+
+    auto result_ptr = std::make_shared<Array>();
+    result_ptr->shape = arr_ptr->shape;
+    if (!apply_unary(vm, *func_info, arr_ptr->data, result_ptr->data)) return {};
+    return result_ptr;
+}
+
+// FILTER(array, predicate@) -> vector
+// Returns a 1D vector of the elements for which the predicate function returns true.
+BasicValue builtin_filter(NeReLaBasic& vm, const std::vector<BasicValue>& args) {
+    if (args.size() != 2) {
+        Error::set(8, vm.runtime_current_line, "FILTER requires 2 arguments: array, predicate_ref");
+        return {};
+    }
+    if (!std::holds_alternative<std::shared_ptr<Array>>(args[0])) {
+        Error::set(15, vm.runtime_current_line, "First argument to FILTER must be an array.");
+        return {};
+    }
+    const auto& arr_ptr = std::get<std::shared_ptr<Array>>(args[0]);
+    if (!arr_ptr) return {};
+    const auto* func_info = resolve_function_ref(vm, args[1], 1, "FILTER");
+    if (!func_info) return {};
+
+    // Evaluate the predicate for all elements first, then gather the survivors.
+    std::vector<BasicValue> keep;
+    if (!apply_unary(vm, *func_info, arr_ptr->data, keep)) return {};
+
+    auto result_ptr = std::make_shared<Array>();
+    for (size_t i = 0; i < arr_ptr->data.size(); ++i) {
+        if (to_bool(keep[i])) result_ptr->data.push_back(arr_ptr->data[i]);
+    }
+    result_ptr->shape = { result_ptr->data.size() };
+    return result_ptr;
+}
+
+// REDUCE(array, function@, [initial_value]) -> value
+// Folds the array from left to right with a two-argument function: acc = f(acc, element).
+// Without an initial value the first element starts the fold.
+BasicValue builtin_reduce(NeReLaBasic& vm, const std::vector<BasicValue>& args) {
+    if (args.size() < 2 || args.size() > 3) {
+        Error::set(8, vm.runtime_current_line, "REDUCE requires 2 or 3 arguments: array, function_ref, [initial_value]");
+        return {};
+    }
+    if (!std::holds_alternative<std::shared_ptr<Array>>(args[0])) {
+        Error::set(15, vm.runtime_current_line, "First argument to REDUCE must be an array.");
+        return {};
+    }
+    const auto& arr_ptr = std::get<std::shared_ptr<Array>>(args[0]);
+    if (!arr_ptr) return {};
+    const auto* func_info = resolve_function_ref(vm, args[1], 2, "REDUCE");
+    if (!func_info) return {};
+
+    const auto& data = arr_ptr->data;
+    size_t start = 0;
+    BasicValue acc;
+    if (args.size() == 3) {
+        acc = args[2];
+    }
+    else {
+        if (data.empty()) {
+            Error::set(15, vm.runtime_current_line, "REDUCE of an empty array requires an initial value.");
+            return {};
+        }
+        acc = data[0];
+        start = 1;
+    }
+
+    // Fast path: built-in binary kernels fold natively.
+    auto kernel_it = NATIVE_BINARY_KERNELS.find(to_upper(func_info->name));
+    if (func_info->native_impl && kernel_it != NATIVE_BINARY_KERNELS.end()) {
+        const BinaryKernel kernel = kernel_it->second;
+        double total = to_double(acc);
+        for (size_t i = start; i < data.size(); ++i) total = kernel(total, to_double(data[i]));
+        return total;
+    }
+
+    std::vector<BasicValue> func_args(2);
+    for (size_t i = start; i < data.size(); ++i) {
+        func_args[0] = acc;
+        func_args[1] = data[i];
+        acc = vm.execute_function_for_value(*func_info, func_args);
+        if (Error::get() != 0) return {}; // Propagate error from user function
+    }
+    return acc;
+}
+
 // IOTA(N) -> vector
 // Generates a vector of numbers from 1 to N.
 BasicValue builtin_iota(NeReLaBasic& vm, const std::vector<BasicValue>& args) {
@@ -1726,6 +2889,77 @@ BasicValue builtin_matmul(NeReLaBasic& vm, const std::vector<BasicValue>& args)
     return result_ptr;
 }
 
+namespace {
+    // Outer products at least this large are computed row-parallel.
+    constexpr size_t PARALLEL_OUTER_THRESHOLD = 1 << 16;
+
+    // Operators understood by OUTER. Resolved once from the operator string so that the
+    // element loop never compares strings.
+    enum class OuterOp { Add, Sub, Mul, Div, Pow, Mod, Min, Max, Eq, Ne, Lt, Gt, Le, Ge };
+
+    bool parse_outer_op(const std::string& op, OuterOp& out) {
+        static const std::unordered_map<std::string, OuterOp> ops = {
+            {"+", OuterOp::Add}, {"-", OuterOp::Sub}, {"*", OuterOp::Mul}, {"/", OuterOp::Div},
+            {"^", OuterOp::Pow}, {"MOD", OuterOp::Mod}, {"MIN", OuterOp::Min}, {"MAX", OuterOp::Max},
+            {"=", OuterOp::Eq}, {"<>", OuterOp::Ne}, {"<", OuterOp::Lt}, {">", OuterOp::Gt},
+            {"<=", OuterOp::Le}, {">=", OuterOp::Ge}
+        };
+        auto it = ops.find(op);
+        if (it == ops.end()) return false;
+        out = it->second;
+        return true;
+    }
+
+    // Fills the rows x cols result of OUTER. Each row is first computed into a plain double
+    // buffer (a loop the compiler can vectorize) and then stored; comparison operators
+    // store booleans. Large products are split into row blocks across threads.
+    template <typename Kernel>
+    void outer_fill(std::vector<BasicValue>& out, const std::vector<double>& a, const std::vector<double>& b, bool as_bool, Kernel kernel) {
+        const size_t rows = a.size();
+        const size_t cols = b.size();
+        size_t workers = 1;
+        if (rows * cols >= PARALLEL_OUTER_THRESHOLD) {
+            workers = worker_count(rows, std::max<size_t>(1, (PARALLEL_OUTER_THRESHOLD / 4) / std::max<size_t>(1, cols)));
+        }
+
+        run_blocks(rows, workers, [&](size_t, size_t row_begin, size_t row_end) {
+            std::vector<double> scratch(cols);
+            for (size_t r = row_begin; r < row_end; ++r) {
+                const double x = a[r];
+                for (size_t c = 0; c < cols; ++c) scratch[c] = kernel(x, b[c]);
+
+                BasicValue* dest = out.data() + r * cols;
+                if (as_bool) {
+                    for (size_t c = 0; c < cols; ++c) dest[c] = (scratch[c] != 0.0);
+                }
+                else {
+                    for (size_t c = 0; c < cols; ++c) dest[c] = scratch[c];
+                }
+            }
+            });
+    }
+
+    template <typename F>
+    void dispatch_outer_op(OuterOp op, F&& f) {
+        switch (op) {
+        case OuterOp::Add: f([](double x, double y) { return x + y; }, false); break;
+        case OuterOp::Sub: f([](double x, double y) { return x - y; }, false); break;
+        case OuterOp::Mul: f([](double x, double y) { return x * y; }, false); break;
+        case OuterOp::Div: f([](double x, double y) { return x / y; }, false); break;
+        case OuterOp::Pow: f([](double x, double y) { return std::pow(x, y); }, false); break;
+        case OuterOp::Mod: f([](double x, double y) { return static_cast<double>(static_cast<long long>(x) % static_cast<long long>(y)); }, false); break;
+        case OuterOp::Min: f([](double x, double y) { return std::min(x, y); }, false); break;
+        case OuterOp::Max: f([](double x, double y) { return std::max(x, y); }, false); break;
+        case OuterOp::Eq:  f([](double x, double y) { return x == y ? 1.0 : 0.0; }, true); break;
+        case OuterOp::Ne:  f([](double x, double y) { return x != y ? 1.0 : 0.0; }, true); break;
+        case OuterOp::Lt:  f([](double x, double y) { return x < y ? 1.0 : 0.0; }, true); break;
+        case OuterOp::Gt:  f([](double x, double y) { return x > y ? 1.0 : 0.0; }, true); break;
+        case OuterOp::Le:  f([](double x, double y) { return x <= y ? 1.0 : 0.0; }, true); break;
+        case OuterOp::Ge:  f([](double x, double y) { return x >= y ? 1.0 : 0.0; }, true); break;
+        }
+    }
+}
+
 // OUTER(arrayA, arrayB, operator_string_or_funcref) -> array
 BasicValue builtin_outer(NeReLaBasic& vm, const std::vector<BasicValue>& args) {
     // 1. Argument validation
@@ -1745,31 +2979,38 @@ BasicValue builtin_outer(NeReLaBasic& vm, const std::vector<BasicValue>& args) {
     auto result_ptr = std::make_shared<Array>();
     result_ptr->shape = a_ptr->shape;
     result_ptr->shape.insert(result_ptr->shape.end(), b_ptr->shape.begin(), b_ptr->shape.end());
-    result_ptr->data.reserve(a_ptr->data.size() * b_ptr->data.size());
 
     const BasicValue& op_arg = args[2];
 
     // 3. Check if the operator is a string
     if (std::holds_alternative<std::string>(op_arg)) {
-        const std::string op = to_upper(std::get<std::string>(op_arg));
-        for (const auto& val_a : a_ptr->data) {
-            for (const auto& val_b : b_ptr->data) {
-                double num_a = to_double(val_a);
-                double num_b = to_double(val_b);
-                if (op == "+") result_ptr->data.push_back(num_a + num_b);
-                else if (op == "-") result_ptr->data.push_back(num_a - num_b);
-                else if (op == "*") result_ptr->data.push_back(num_a * num_b);
-                else if (op == "^") result_ptr->data.push_back(pow(num_a, num_b));
-                else if (op == "/") {
-                    if (num_b == 0.0) { Error::set(2, vm.runtime_current_line); return {}; }
-                    result_ptr->data.push_back(num_a / num_b);
-                }
-                else if (op == "=") result_ptr->data.push_back(num_a == num_b);
-                else if (op == ">") result_ptr->data.push_back(num_a > num_b);
-                else if (op == "<") result_ptr->data.push_back(num_a < num_b);
-                else { Error::set(1, vm.runtime_current_line, "Invalid operator string: " + op); return {}; }
-            }
+        const std::string op_str = to_upper(std::get<std::string>(op_arg));
+        OuterOp op;
+        if (!parse_outer_op(op_str, op)) {
+            Error::set(1, vm.runtime_current_line, "Invalid operator string: " + op_str);
+            return {};
+        }
+
+        std::vector<double> a_vals, b_vals;
+        a_vals.reserve(a_ptr->data.size());
+        b_vals.reserve(b_ptr->data.size());
+        for (const auto& val : a_ptr->data) a_vals.push_back(to_double(val));
+        for (const auto& val : b_ptr->data) b_vals.push_back(to_double(val));
+
+        // Division by zero is checked up front so the kernels stay branch-free.
+        if (op == OuterOp::Div || op == OuterOp::Mod) {
+            for (double y : b_vals) {
+                if ((op == OuterOp::Div && y == 0.0) || (op == OuterOp::Mod && static_cast<long long>(y) == 0)) {
+                    Error::set(2, vm.runtime_current_line);
+                    return {};
+                }
+            }
         }
+
+        result_ptr->data.resize(a_vals.size() * b_vals.size());
+        dispatch_outer_op(op, [&](auto kernel, bool as_bool) {
+            outer_fill(result_ptr->data, a_vals, b_vals, as_bool, kernel);
+            });
     }
     // 4. Check if the operator is a function reference
     else if (std::holds_alternative<FunctionRef>(op_arg)) {
@@ -1784,9 +3025,12 @@ BasicValue builtin_outer(NeReLaBasic& vm, const std::vector<BasicValue>& args) {
             return {};
         }
 
+        result_ptr->data.reserve(a_ptr->data.size() * b_ptr->data.size());
+        std::vector<BasicValue> func_args(2);
         for (const auto& val_a : a_ptr->data) {
             for (const auto& val_b : b_ptr->data) {
-                std::vector<BasicValue> func_args = { val_a, val_b };
+                func_args[0] = val_a;
+                func_args[1] = val_b;
                 BasicValue result = vm.execute_function_for_value(func_info, func_args);
                 if (Error::get() != 0) return {}; // Propagate error from user function
                 result_ptr->data.push_back(result);
@@ -1801,12 +3045,128 @@ BasicValue builtin_outer(NeReLaBasic& vm, const std::vector<BasicValue>& args) {
     return result_ptr;
 }
 
-// INTEGRATE(function@, limits, rule) 
-// INTEGRATE function This is the core logic. It parses arguments, performs the coordinate transformation, and loops through the Gauss points to calculate the final sum.
+namespace {
+    // 15-point Gauss-Kronrod rule on [-1, 1] (nodes for x >= 0, symmetric).
+    // The embedded 7-point Gauss rule uses the odd-indexed Kronrod nodes.
+    const double KRONROD_NODES[8] = {
+        0.991455371120812639206854697526329, 0.949107912342758524526189684047851,
+        0.864864423359769072789712788640926, 0.741531185599394439863864773280788,
+        0.586087235467691130294144845693013, 0.405845151377397166906606412076961,
+        0.207784955007898467600689403773245, 0.000000000000000000000000000000000
+    };
+    const double KRONROD_WEIGHTS[8] = {
+        0.022935322010529224963732008058970, 0.063092092629978553290700663189204,
+        0.104790010322250183839876322541518, 0.140653259715525918745189590510238,
+        0.169004726639267902826583426598550, 0.190350578064785409913256402421014,
+        0.204432940075298892414161999234649, 0.209482141084727828012999174891714
+    };
+    const double GAUSS7_WEIGHTS[4] = {
+        0.129484966168869693270611432679082, 0.279705391489276667901467771423780,
+        0.381830050505118944950369775488975, 0.417959183673469387755102040816327
+    };
+
+    constexpr int ADAPTIVE_MAX_PANELS = 500;
+
+    // Evaluates the integrand at a set of points. coords[d][i] is coordinate d of point i.
+    // In batch mode the BASIC function is called once with one array per coordinate and
+    // must return an array with one value per point (or a scalar, used for all points).
+    // Otherwise it is called once per point.
+    class IntegrandEvaluator {
+    public:
+        IntegrandEvaluator(NeReLaBasic& vm, const NeReLaBasic::FunctionInfo& func_info, bool batch)
+            : vm(vm), func_info(func_info), batch(batch) {}
+
+        bool evaluate(const std::vector<std::vector<double>>& coords, std::vector<double>& out) {
+            const size_t dims = coords.size();
+            const size_t count = coords.empty() ? 0 : coords[0].size();
+            out.resize(count);
+
+            if (batch) {
+                std::vector<BasicValue> func_args;
+                for (const auto& axis : coords) {
+                    auto axis_ptr = std::make_shared<Array>();
+                    axis_ptr->shape = { axis.size() };
+                    axis_ptr->data.assign(axis.begin(), axis.end());
+                    func_args.push_back(axis_ptr);
+                }
+                BasicValue result = vm.execute_function_for_value(func_info, func_args);
+                if (Error::get() != 0) return false;
+
+                if (std::holds_alternative<std::shared_ptr<Array>>(result)) {
+                    const auto& res_ptr = std::get<std::shared_ptr<Array>>(result);
+                    if (!res_ptr || res_ptr->data.size() != count) {
+                        Error::set(15, vm.runtime_current_line, "Batch integrand must return one value per point.");
+                        return false;
+                    }
+                    for (size_t i = 0; i < count; ++i) out[i] = to_double(res_ptr->data[i]);
+                }
+                else {
+                    std::fill(out.begin(), out.end(), to_double(result));
+                }
+                return true;
+            }
+
+            std::vector<BasicValue> func_args(dims);
+            for (size_t i = 0; i < count; ++i) {
+                for (size_t d = 0; d < dims; ++d) func_args[d] = coords[d][i];
+                out[i] = to_double(vm.execute_function_for_value(func_info, func_args));
+                if (Error::get() != 0) return false; // e.g. division by zero inside the user func
+            }
+            return true;
+        }
+
+    private:
+        NeReLaBasic& vm;
+        const NeReLaBasic::FunctionInfo& func_info;
+        bool batch;
+    };
+
+    // One panel [a, b] of the adaptive integration with its Kronrod estimate and error.
+    struct Panel {
+        double a, b, value, error;
+        bool operator<(const Panel& other) const { return error < other.error; }
+    };
+
+    // Applies the 15-point Gauss-Kronrod rule to [a, b]. The error estimate is the
+    // difference between the Kronrod and the embedded Gauss result.
+    bool kronrod_panel(IntegrandEvaluator& f, double a, double b, Panel& panel) {
+        const double center = 0.5 * (a + b);
+        const double half = 0.5 * (b - a);
+
+        std::vector<std::vector<double>> coords(1);
+        coords[0].reserve(15);
+        coords[0].push_back(center);
+        for (int i = 0; i < 7; ++i) {
+            coords[0].push_back(center - half * KRONROD_NODES[i]);
+            coords[0].push_back(center + half * KRONROD_NODES[i]);
+        }
+
+        std::vector<double> fx;
+        if (!f.evaluate(coords, fx)) return false;
+
+        double kronrod = KRONROD_WEIGHTS[7] * fx[0];
+        double gauss = GAUSS7_WEIGHTS[3] * fx[0];
+        for (int i = 0; i < 7; ++i) {
+            const double pair = fx[1 + 2 * i] + fx[2 + 2 * i];
+            kronrod += KRONROD_WEIGHTS[i] * pair;
+            if (i % 2 == 1) gauss += GAUSS7_WEIGHTS[i / 2] * pair;
+        }
+
+        panel = { a, b, kronrod * half, std::abs((kronrod - gauss) * half) };
+        return true;
+    }
+}
+
+// INTEGRATE(function@, domain, rule, [tolerance], [batch])
+// Integrates a function over a 1D interval [a, b] or a 2D/3D box [[a1, b1], [a2, b2], ...].
+// rule 1-5 uses a fixed Gauss-Legendre rule (tensor product for boxes); rule 0 integrates
+// a 1D interval adaptively with 15-point Gauss-Kronrod panels until the estimated error is
+// below tolerance (default 1e-10). With batch = TRUE the function receives arrays holding
+// all quadrature points at once and must return an array of values.
 BasicValue builtin_integrate(NeReLaBasic& vm, const std::vector<BasicValue>& args) {
     // 1. --- Argument Validation ---
-    if (args.size() != 3) {
-        Error::set(8, vm.runtime_current_line, "INTEGRATE requires 3 arguments: function_ref, domain_array, order");
+    if (args.size() < 3 || args.size() > 5) {
+        Error::set(8, vm.runtime_current_line, "INTEGRATE requires 3 to 5 arguments: function_ref, domain_array, rule, [tolerance], [batch]");
         return 0.0;
     }
     if (!std::holds_alternative<FunctionRef>(args[0])) {
@@ -1814,7 +3174,7 @@ BasicValue builtin_integrate(NeReLaBasic& vm, const std::vector<BasicValue>& arg
         return 0.0;
     }
     if (!std::holds_alternative<std::shared_ptr<Array>>(args[1])) {
-        Error::set(15, vm.runtime_current_line, "Second argument to INTEGRATE must be a 1D array with 2 elements for the domain.");
+        Error::set(15, vm.runtime_current_line, "Second argument to INTEGRATE must be an array [a, b] or [[a1, b1], ...] for the domain.");
         return 0.0;
     }
 
@@ -1822,60 +3182,97 @@ BasicValue builtin_integrate(NeReLaBasic& vm, const std::vector<BasicValue>& arg
     const std::string func_name = to_upper(std::get<FunctionRef>(args[0]).name);
     const auto& domain_ptr = std::get<std::shared_ptr<Array>>(args[1]);
     const int order = static_cast<int>(to_double(args[2]));
+    const double tolerance = (args.size() > 3) ? to_double(args[3]) : 1e-10;
+    const bool batch = (args.size() > 4) ? to_bool(args[4]) : false;
 
     // 3. --- Further Validation ---
+    if (!domain_ptr || domain_ptr->data.empty() || domain_ptr->data.size() % 2 != 0) {
+        Error::set(15, vm.runtime_current_line, "Domain array for INTEGRATE must hold [a, b] pairs.");
+        return 0.0;
+    }
+    const size_t dims = domain_ptr->data.size() / 2;
+    if (dims > 3) {
+        Error::set(15, vm.runtime_current_line, "INTEGRATE supports domains of up to 3 dimensions.");
+        return 0.0;
+    }
     if (!vm.active_function_table->count(func_name)) {
         Error::set(22, vm.runtime_current_line, "Function '" + func_name + "' not found for integration.");
         return 0.0;
     }
     const auto& func_info = vm.active_function_table->at(func_name);
-    if (func_info.arity != 1) {
-        Error::set(26, vm.runtime_current_line, "Function '" + func_name + "' must accept exactly one argument.");
+    if (func_info.arity != static_cast<int>(dims)) {
+        Error::set(26, vm.runtime_current_line, "Function '" + func_name + "' must accept exactly " + std::to_string(dims) + " argument(s).");
         return 0.0;
     }
-    if (!domain_ptr || domain_ptr->data.size() != 2) {
-        Error::set(15, vm.runtime_current_line, "Domain array for INTEGRATE must have exactly two elements [a, b].");
+    if (order != 0 && GAUSS_RULES.find(order) == GAUSS_RULES.end()) {
+        Error::set(1, vm.runtime_current_line, "Unsupported integration order: " + std::to_string(order) + ". Supported orders are 0 (adaptive) and 1-5.");
         return 0.0;
     }
-    if (GAUSS_RULES.find(order) == GAUSS_RULES.end()) {
-        Error::set(1, vm.runtime_current_line, "Unsupported integration order: " + std::to_string(order) + ". Supported orders are 1-5.");
+    if (order == 0 && dims != 1) {
+        Error::set(1, vm.runtime_current_line, "Adaptive integration (rule 0) is only supported for 1D domains.");
         return 0.0;
     }
 
-    // 4. --- Integration Logic ---
-    const double a = to_double(domain_ptr->data[0]); // Lower limit
-    const double b = to_double(domain_ptr->data[1]); // Upper limit
-    const GaussRule& rule = GAUSS_RULES.at(order);
-
-    double integral_sum = 0.0;
-
-    // The integral of f(x) from a to b is transformed to an integral from -1 to 1.
-    // The change of variable is: x = (a+b)/2 + (b-a)/2 * xi
-    // The differential becomes: dx = (b-a)/2 * dxi
-    // The term (b-a)/2 is the Jacobian of the transformation.
-    const double jacobian = (b - a) / 2.0;
-
-    for (size_t i = 0; i < rule.points.size(); ++i) {
-        const double weight = rule.weights[i];
-        const double gauss_point_xi = rule.points[i]; // This is the point in [-1, 1]
-
-        // Map the Gauss point from the natural coordinate 'xi' to the physical coordinate 'x'
-        const double physical_point_x = 0.5 * (a + b) + 0.5 * (b - a) * gauss_point_xi;
-
-        // Prepare argument to pass to the user's BASIC function
-        std::vector<BasicValue> args_to_pass = { physical_point_x };
-
-        // Execute the user's BASIC function to get the value of the integrand f(x)
-        BasicValue f_of_x_val = vm.execute_function_for_value(func_info, args_to_pass);
-
-        // Check for errors during function execution (e.g., division by zero inside the user func)
-        if (Error::get() != 0) {
-            return 0.0;
+    IntegrandEvaluator integrand(vm, func_info, batch);
+
+    // 4. --- Adaptive Gauss-Kronrod ---
+    // Repeatedly bisects the panel with the largest error estimate.
+    if (order == 0) {
+        const double a = to_double(domain_ptr->data[0]);
+        const double b = to_double(domain_ptr->data[1]);
+
+        std::priority_queue<Panel> panels;
+        Panel first;
+        if (!kronrod_panel(integrand, a, b, first)) return 0.0;
+        panels.push(first);
+        double total = first.value;
+        double total_error = first.error;
+
+        for (int count = 1; total_error > tolerance && count < ADAPTIVE_MAX_PANELS; ++count) {
+            Panel worst = panels.top();
+            panels.pop();
+            const double mid = 0.5 * (worst.a + worst.b);
+            Panel left, right;
+            if (!kronrod_panel(integrand, worst.a, mid, left) || !kronrod_panel(integrand, mid, worst.b, right)) return 0.0;
+            total += left.value + right.value - worst.value;
+            total_error += left.error + right.error - worst.error;
+            panels.push(left);
+            panels.push(right);
         }
+        return total;
+    }
 
-        integral_sum += weight * to_double(f_of_x_val);
+    // 5. --- Fixed Gauss-Legendre (tensor product over all dimensions) ---
+    // Each axis is transformed from [-1, 1] to [a, b] with x = (a+b)/2 + (b-a)/2 * xi,
+    // so dx = (b-a)/2 * dxi. The Jacobian is the product of these factors.
+    const GaussRule& rule = GAUSS_RULES.at(order);
+    const size_t n = rule.points.size();
+    size_t total_points = 1;
+    for (size_t d = 0; d < dims; ++d) total_points *= n;
+
+    std::vector<std::vector<double>> coords(dims, std::vector<double>(total_points));
+    std::vector<double> weights(total_points, 1.0);
+    double jacobian = 1.0;
+    for (size_t d = 0; d < dims; ++d) {
+        const double a = to_double(domain_ptr->data[2 * d]);
+        const double b = to_double(domain_ptr->data[2 * d + 1]);
+        jacobian *= (b - a) / 2.0;
+
+        // Point p enumerates the grid with the last axis varying fastest.
+        size_t stride = 1;
+        for (size_t k = d + 1; k < dims; ++k) stride *= n;
+        for (size_t p = 0; p < total_points; ++p) {
+            const size_t i = (p / stride) % n;
+            coords[d][p] = 0.5 * (a + b) + 0.5 * (b - a) * rule.points[i];
+            weights[p] *= rule.weights[i];
+        }
     }
 
+    std::vector<double> fx;
+    if (!integrand.evaluate(coords, fx)) return 0.0;
+
+    double integral_sum = 0.0;
+    for (size_t p = 0; p < total_points; ++p) integral_sum += weights[p] * fx[p];
     return integral_sum * jacobian;
 }
 
@@ -2424,6 +3821,7 @@ BasicValue builtin_sleep(NeReLaBasic& vm, const std::vector<BasicValue>& args) {
         return false;
     }
     int milliseconds = static_cast<int>(to_double(args[0]));
+    TextIO::flush(); // Show everything printed so far while we wait
     if (milliseconds > 0) {
         std::this_thread::sleep_for(std::chrono::milliseconds(milliseconds));
     }
@@ -2457,6 +3855,18 @@ BasicValue builtin_option(NeReLaBasic& vm, const std::vector<BasicValue>& args)
         vm.nopause_active = false;
         TextIO::print("OPTION PAUSE is active. Break/Pause enabled.\n");
     }
+    else if (option_str == "UNBUFFERED") { // Write console output immediately
+        TextIO::set_buffered(false);
+    }
+    else if (option_str == "BUFFERED") {
+        TextIO::set_buffered(true);
+    }
+    else if (option_str == "SORTEDMAPS") { // New maps list their keys in sorted order
+        Map::sorted_by_default = true;
+    }
+    else if (option_str == "ORDEREDMAPS") { // New maps list their keys in insertion order (default)
+        Map::sorted_by_default = false;
+    }
     // Add more else if blocks here for future options, e.g.:
     // else if (option_str == "GRAPHICSON") {
     //     // vm.graphics_enabled = true;
@@ -2669,10 +4079,14 @@ BasicValue builtin_txtreader_str(NeReLaBasic& vm, const std::vector<BasicValue>&
         return std::string("");
     }
 
-    // Read the whole file into a stringstream buffer, then into a string.
-    std::stringstream buffer;
-    buffer << infile.rdbuf();
-    return buffer.str();
+    // Size the string once and read straight into it (text mode may shrink it).
+    infile.seekg(0, std::ios::end);
+    std::streamoff size = infile.tellg();
+    infile.seekg(0, std::ios::beg);
+    std::string content(size > 0 ? static_cast<size_t>(size) : 0, '\0');
+    infile.read(content.data(), static_cast<std::streamsize>(content.size()));
+    content.resize(static_cast<size_t>(infile.gcount()));
+    return content;
 }
 
 
@@ -2699,61 +4113,318 @@ BasicValue builtin_csvreader(NeReLaBasic& vm, const std::vector<BasicValue>& arg
         has_header = to_bool(args[2]);
     }
 
-    // --- 2. Open File ---
-    std::ifstream infile(filename);
-    if (!infile) {
+    // --- 2. Open File (memory-mapped) ---
+    FileIO::CsvReader reader;
+    if (!reader.open(filename, delimiter, has_header)) {
         Error::set(6, vm.runtime_current_line); // File not found
         return {};
     }
 
-    // --- 3. Read and Parse ---
-    std::vector<BasicValue> flat_data;
+    // --- 3. Parse straight into the result array ---
+    // Every row must have as many cells as the first one.
+    auto result_ptr = std::make_shared<Array>();
     size_t rows = 0;
     size_t cols = 0;
-    std::string line;
+    if (!reader.read_numeric(0, result_ptr->data, rows, cols)) {
+        Error::set(15, vm.runtime_current_line); // Type Mismatch (or a new "Invalid file format" error)
+        return {};
+    }
+    result_ptr->shape = { rows, cols };
+    return result_ptr;
+}
 
-    // Handle header row if specified
-    if (has_header && std::getline(infile, line)) {
-        // Just consume the line and do nothing with it.
+// Looks up the CSV cursor behind a handle argument. Sets an error if it is not open.
+static FileIO::CsvReader* get_csv_cursor(NeReLaBasic& vm, const BasicValue& handle) {
+    auto it = vm.csv_cursors.find(static_cast<int>(to_double(handle)));
+    if (it == vm.csv_cursors.end()) {
+        Error::set(12, vm.runtime_current_line, "CSV handle is not open.");
+        return nullptr;
     }
+    return it->second.get();
+}
 
-    // Loop through the rest of the file
-    while (std::getline(infile, line)) {
-        rows++;
-        std::stringstream line_stream(line);
-        std::string cell;
-        size_t current_cols = 0;
-
-        while (std::getline(line_stream, cell, delimiter)) {
-            current_cols++;
-            try {
-                // Try to convert each cell to a number.
-                flat_data.push_back(std::stod(cell));
-            }
-            catch (const std::invalid_argument&) {
-                // If conversion fails, store 0.0, a common practice.
-                flat_data.push_back(0.0);
-            }
+// CSVOPEN(filename$, [delimiter$], [has_header_bool], [columns]) -> handle
+// Opens a delimited file for reading in blocks with CSVNEXT. 'columns' is an array of
+// 0-based column numbers or header names; only those columns are parsed.
+BasicValue builtin_csvopen(NeReLaBasic& vm, const std::vector<BasicValue>& args) {
+    if (args.empty() || args.size() > 4) {
+        Error::set(8, vm.runtime_current_line);
+        return 0.0;
+    }
+
+    std::string filename = to_string(args[0]);
+    char delimiter = ',';
+    bool has_header = false;
+    if (args.size() > 1) {
+        std::string delim_str = to_string(args[1]);
+        if (!delim_str.empty()) {
+            delimiter = delim_str[0];
         }
+    }
+    if (args.size() > 2) {
+        has_header = to_bool(args[2]);
+    }
+
+    auto reader = std::make_unique<FileIO::CsvReader>();
+    if (!reader->open(filename, delimiter, has_header)) {
+        Error::set(6, vm.runtime_current_line); // File not found
+        return 0.0;
+    }
 
-        // --- 4. Determine Shape and Validate ---
-        if (rows == 1) {
-            // This is the first data row, so it determines the number of columns.
-            cols = current_cols;
+    // Column selection by number or by header name.
+    if (args.size() > 3) {
+        if (!std::holds_alternative<std::shared_ptr<Array>>(args[3])) {
+            Error::set(15, vm.runtime_current_line, "Column selection for CSVOPEN must be an array.");
+            return 0.0;
         }
-        else {
-            // For all subsequent rows, verify they have the correct number of columns.
-            if (current_cols != cols) {
-                Error::set(15, vm.runtime_current_line); // Type Mismatch (or a new "Invalid file format" error)
-                return {};
+        const auto& cols_ptr = std::get<std::shared_ptr<Array>>(args[3]);
+        std::vector<size_t> columns;
+        const auto& header = reader->header();
+        for (const auto& col : cols_ptr ? cols_ptr->data : std::vector<BasicValue>{}) {
+            if (std::holds_alternative<std::string>(col)) {
+                const std::string name = to_upper(std::get<std::string>(col));
+                auto it = std::find_if(header.begin(), header.end(), [&](const std::string& h) { return to_upper(h) == name; });
+                if (it == header.end()) {
+                    Error::set(3, vm.runtime_current_line, "Column '" + std::get<std::string>(col) + "' not found in header.");
+                    return 0.0;
+                }
+                columns.push_back(static_cast<size_t>(it - header.begin()));
+            }
+            else {
+                double index = to_double(col);
+                if (index < 0) { Error::set(10, vm.runtime_current_line); return 0.0; }
+                columns.push_back(static_cast<size_t>(index));
             }
         }
+        reader->select_columns(std::move(columns));
+    }
+
+    int handle = vm.next_csv_cursor++;
+    vm.csv_cursors[handle] = std::move(reader);
+    return static_cast<double>(handle);
+}
+
+// CSVNEXT(handle, nrows) -> array
+// Reads the next block of up to nrows rows as a 2D array of numbers.
+// Returns an array with 0 rows once the end of the file is reached.
+BasicValue builtin_csvnext(NeReLaBasic& vm, const std::vector<BasicValue>& args) {
+    if (args.size() != 2) {
+        Error::set(8, vm.runtime_current_line);
+        return {};
+    }
+    FileIO::CsvReader* reader = get_csv_cursor(vm, args[0]);
+    if (!reader) return {};
+    double nrows = to_double(args[1]);
+    if (nrows < 1) {
+        Error::set(10, vm.runtime_current_line, "CSVNEXT needs a row count of at least 1.");
+        return {};
     }
 
-    // --- 5. Create and Return the Array ---
     auto result_ptr = std::make_shared<Array>();
+    size_t rows = 0;
+    size_t cols = 0;
+    if (!reader->read_numeric(static_cast<size_t>(nrows), result_ptr->data, rows, cols)) {
+        Error::set(15, vm.runtime_current_line); // Row with a different number of cells
+        return {};
+    }
     result_ptr->shape = { rows, cols };
-    result_ptr->data = flat_data;
+    return result_ptr;
+}
+
+// CSVEOF(handle) -> boolean
+// Returns TRUE when all rows of an open CSV cursor have been read.
+BasicValue builtin_csveof(NeReLaBasic& vm, const std::vector<BasicValue>& args) {
+    if (args.size() != 1) {
+        Error::set(8, vm.runtime_current_line);
+        return true;
+    }
+    FileIO::CsvReader* reader = get_csv_cursor(vm, args[0]);
+    if (!reader) return true;
+    return reader->at_end();
+}
+
+// CSVCLOSE handle
+// Closes a CSV cursor opened with CSVOPEN.
+BasicValue builtin_csvclose(NeReLaBasic& vm, const std::vector<BasicValue>& args) {
+    if (args.size() != 1) {
+        Error::set(8, vm.runtime_current_line);
+        return false;
+    }
+    if (!get_csv_cursor(vm, args[0])) return false;
+    vm.csv_cursors.erase(static_cast<int>(to_double(args[0])));
+    return false;
+}
+
+namespace {
+    // Column types inferred by TABLEREAD, from most to least specific.
+    enum class ColumnType { Integer, Double, Date, String };
+
+    // Parses "YYYY-MM-DD" with an optional " HH:MM[:SS]" or "THH:MM[:SS]" time part.
+    bool parse_date_field(std::string_view field, DateTime& out) {
+        auto number = [&](size_t at, size_t len, int& value) {
+            if (at + len > field.size()) return false;
+            auto [ptr, ec] = std::from_chars(field.data() + at, field.data() + at + len, value);
+            return ec == std::errc() && ptr == field.data() + at + len;
+        };
+
+        std::tm tm = {};
+        if (field.size() < 10 || field[4] != '-' || field[7] != '-') return false;
+        if (!number(0, 4, tm.tm_year) || !number(5, 2, tm.tm_mon) || !number(8, 2, tm.tm_mday)) return false;
+        if (field.size() > 10) {
+            if ((field[10] != ' ' && field[10] != 'T') || field.size() < 16 || field[13] != ':') return false;
+            if (!number(11, 2, tm.tm_hour) || !number(14, 2, tm.tm_min)) return false;
+            if (field.size() > 16 && (field[16] != ':' || field.size() != 19 || !number(17, 2, tm.tm_sec))) return false;
+        }
+        if (tm.tm_mon < 1 || tm.tm_mon > 12 || tm.tm_mday < 1 || tm.tm_mday > 31) return false;
+        tm.tm_year -= 1900;
+        tm.tm_mon -= 1;
+        tm.tm_isdst = -1;
+
+        time_t time = std::mktime(&tm);
+        if (time == -1) return false;
+        out = DateTime{ std::chrono::system_clock::from_time_t(time) };
+        return true;
+    }
+
+    // Picks the most specific type every non-empty cell of a column fits.
+    ColumnType infer_column_type(const std::vector<std::string_view>& cells) {
+        bool can_int = true, can_double = true, can_date = true;
+        for (std::string_view raw : cells) {
+            std::string cell = FileIO::unquote_field(raw);
+            if (cell.empty()) continue; // Missing values do not decide the type
+            if (can_int) {
+                long long value;
+                auto [ptr, ec] = std::from_chars(cell.data(), cell.data() + cell.size(), value);
+                can_int = ec == std::errc() && ptr == cell.data() + cell.size() &&
+                    value >= std::numeric_limits<int>::min() && value <= std::numeric_limits<int>::max();
+            }
+            if (can_double && !can_int) {
+                double value;
+                can_double = FileIO::parse_double(cell, value, true);
+            }
+            if (can_date) {
+                DateTime value;
+                can_date = parse_date_field(cell, value);
+            }
+            if (!can_int && !can_double && !can_date) break;
+        }
+        if (can_int) return ColumnType::Integer;
+        if (can_double) return ColumnType::Double;
+        if (can_date) return ColumnType::Date;
+        return ColumnType::String;
+    }
+}
+
+// TABLEREAD(filename$, [delimiter$], [has_header_bool]) -> map
+// Reads a delimited file with mixed column types into a columnar table. The result is a
+// Map with "HEADERS" (column names), "TYPES" ("INTEGER", "DOUBLE", "DATE" or "STRING"),
+// "ROWS" (row count) and "COLUMNS", a Map from column name to a 1D array of its values.
+// Empty cells become 0 in numeric columns and "" otherwise. Repeated column names get a
+// suffix (VALUE, VALUE_2, ...), the same in HEADERS and COLUMNS.
+BasicValue builtin_tableread(NeReLaBasic& vm, const std::vector<BasicValue>& args) {
+    if (args.empty() || args.size() > 3) {
+        Error::set(8, vm.runtime_current_line);
+        return {};
+    }
+
+    // --- 1. Parse Arguments ---
+    std::string filename = to_string(args[0]);
+    char delimiter = ',';
+    bool has_header = true;
+    if (args.size() > 1) {
+        std::string delim_str = to_string(args[1]);
+        if (!delim_str.empty()) {
+            delimiter = delim_str[0];
+        }
+    }
+    if (args.size() > 2) {
+        has_header = to_bool(args[2]);
+    }
+
+    FileIO::CsvReader reader;
+    if (!reader.open(filename, delimiter, has_header)) {
+        Error::set(6, vm.runtime_current_line); // File not found
+        return {};
+    }
+
+    // --- 2. Gather the raw cells column by column (views into the mapped file) ---
+    std::vector<std::vector<std::string_view>> columns;
+    std::vector<std::string_view> fields;
+    size_t rows = 0;
+    while (reader.next_fields(fields)) {
+        if (rows == 0) {
+            columns.resize(std::max(fields.size(), reader.header().size()));
+        }
+        if (fields.size() > columns.size()) {
+            Error::set(15, vm.runtime_current_line, "Row " + std::to_string(rows + 1) + " has more cells than the table.");
+            return {};
+        }
+        for (size_t c = 0; c < columns.size(); ++c) {
+            columns[c].push_back(c < fields.size() ? fields[c] : std::string_view{}); // Short rows are padded
+        }
+        rows++;
+    }
+    if (columns.empty()) columns.resize(reader.header().size());
+
+    // --- 3. Convert every column to its inferred type ---
+    auto headers_ptr = std::make_shared<Array>();
+    auto types_ptr = std::make_shared<Array>();
+    auto columns_map = std::make_shared<Map>();
+    static const char* TYPE_NAMES[] = { "INTEGER", "DOUBLE", "DATE", "STRING" };
+
+    for (size_t c = 0; c < columns.size(); ++c) {
+        std::string name = (c < reader.header().size() && !reader.header()[c].empty())
+            ? reader.header()[c] : "COLUMN" + std::to_string(c + 1);
+        if (columns_map->data.contains(name)) {
+            // A repeated name gets a suffix, so every column stays reachable: VALUE, VALUE_2, ...
+            int suffix = 2;
+            while (columns_map->data.contains(name + "_" + std::to_string(suffix))) ++suffix;
+            name += "_" + std::to_string(suffix);
+        }
+        const ColumnType type = infer_column_type(columns[c]);
+
+        auto column_ptr = std::make_shared<Array>();
+        column_ptr->shape = { rows };
+        column_ptr->data.reserve(rows);
+        for (std::string_view raw : columns[c]) {
+            std::string cell = FileIO::unquote_field(raw);
+            switch (type) {
+            case ColumnType::Integer: {
+                int value = 0;
+                std::from_chars(cell.data(), cell.data() + cell.size(), value);
+                column_ptr->data.push_back(value);
+                break;
+            }
+            case ColumnType::Double: {
+                double value = 0.0;
+                FileIO::parse_double(cell, value);
+                column_ptr->data.push_back(value);
+                break;
+            }
+            case ColumnType::Date: {
+                DateTime value;
+                if (parse_date_field(cell, value)) column_ptr->data.push_back(value);
+                else column_ptr->data.push_back(std::string(""));
+                break;
+            }
+            case ColumnType::String:
+                column_ptr->data.push_back(std::move(cell));
+                break;
+            }
+        }
+
+        headers_ptr->data.push_back(name);
+        types_ptr->data.push_back(std::string(TYPE_NAMES[static_cast<int>(type)]));
+        columns_map->data[name] = column_ptr;
+    }
+    headers_ptr->shape = { headers_ptr->data.size() };
+    types_ptr->shape = { types_ptr->data.size() };
+
+    auto result_ptr = std::make_shared<Map>();
+    result_ptr->data["HEADERS"] = headers_ptr;
+    result_ptr->data["TYPES"] = types_ptr;
+    result_ptr->data["ROWS"] = static_cast<double>(rows);
+    result_ptr->data["COLUMNS"] = columns_map;
     return result_ptr;
 }
 
@@ -2778,10 +4449,153 @@ BasicValue builtin_txtwriter(NeReLaBasic& vm, const std::vector<BasicValue>& arg
     return false; // Procedures return a dummy value
 }
 
-// CSVWRITER filename$, array, [delimiter$], [header_array]
-// Writes a 2D array to a CSV file, with an optional header row.
+// --- Buffered File Handles ---
+
+// Looks up the open file behind a handle argument. Sets an error if it is not open.
+static FileIO::TextFile* get_file_handle(NeReLaBasic& vm, const BasicValue& handle) {
+    auto it = vm.file_handles.find(static_cast<int>(to_double(handle)));
+    if (it == vm.file_handles.end()) {
+        Error::set(12, vm.runtime_current_line, "File handle is not open.");
+        return nullptr;
+    }
+    return it->second.get();
+}
+
+// FILE.OPEN(filename$, [mode$]) -> handle
+// Opens a text file. mode$ is "R" to read (default), "W" to write or "A" to append.
+BasicValue builtin_file_open(NeReLaBasic& vm, const std::vector<BasicValue>& args) {
+    if (args.empty() || args.size() > 2) {
+        Error::set(8, vm.runtime_current_line);
+        return 0.0;
+    }
+    std::string filename = to_string(args[0]);
+    std::string mode_str = (args.size() > 1) ? to_upper(to_string(args[1])) : "R";
+
+    FileIO::TextFile::Mode mode;
+    if (mode_str == "R" || mode_str == "INPUT") mode = FileIO::TextFile::Mode::Read;
+    else if (mode_str == "W" || mode_str == "OUTPUT") mode = FileIO::TextFile::Mode::Write;
+    else if (mode_str == "A" || mode_str == "APPEND") mode = FileIO::TextFile::Mode::Append;
+    else {
+        Error::set(1, vm.runtime_current_line, "Invalid file mode: " + mode_str);
+        return 0.0;
+    }
+
+    auto file = std::make_unique<FileIO::TextFile>();
+    if (!file->open(filename, mode)) {
+        Error::set(mode == FileIO::TextFile::Mode::Read ? 6 : 12, vm.runtime_current_line);
+        return 0.0;
+    }
+
+    int handle = vm.next_file_handle++;
+    vm.file_handles[handle] = std::move(file);
+    return static_cast<double>(handle);
+}
+
+// FILE.READLINE$(handle) -> string$
+// Reads the next line of a file opened for reading (like LINE INPUT #).
+BasicValue builtin_file_readline_str(NeReLaBasic& vm, const std::vector<BasicValue>& args) {
+    if (args.size() != 1) {
+        Error::set(8, vm.runtime_current_line);
+        return std::string("");
+    }
+    FileIO::TextFile* file = get_file_handle(vm, args[0]);
+    if (!file) return std::string("");
+    if (file->mode() != FileIO::TextFile::Mode::Read) {
+        Error::set(12, vm.runtime_current_line, "File was not opened for reading.");
+        return std::string("");
+    }
+
+    std::string line;
+    if (!file->read_line(line)) {
+        Error::set(12, vm.runtime_current_line, "Read past end of file.");
+        return std::string("");
+    }
+    return line;
+}
+
+// FILE.EOF(handle) -> boolean
+// Returns TRUE when there is nothing more to read.
+BasicValue builtin_file_eof(NeReLaBasic& vm, const std::vector<BasicValue>& args) {
+    if (args.size() != 1) {
+        Error::set(8, vm.runtime_current_line);
+        return true;
+    }
+    FileIO::TextFile* file = get_file_handle(vm, args[0]);
+    if (!file) return true;
+    return file->eof();
+}
+
+// Shared by FILE.WRITE and FILE.WRITELINE.
+static BasicValue file_write(NeReLaBasic& vm, const std::vector<BasicValue>& args, bool newline) {
+    if (args.size() != 2) {
+        Error::set(8, vm.runtime_current_line);
+        return false;
+    }
+    FileIO::TextFile* file = get_file_handle(vm, args[0]);
+    if (!file) return false;
+
+    std::string text = to_string(args[1]);
+    if (newline) text += '\n';
+    if (!file->write(text)) {
+        Error::set(12, vm.runtime_current_line); // File I/O Error
+    }
+    return false;
+}
+
+// FILE.WRITE handle, value
+// Writes a value to a file opened for writing or appending.
+BasicValue builtin_file_write(NeReLaBasic& vm, const std::vector<BasicValue>& args) {
+    return file_write(vm, args, false);
+}
+
+// FILE.WRITELINE handle, value
+// Writes a value followed by a line break (like PRINT #).
+BasicValue builtin_file_writeline(NeReLaBasic& vm, const std::vector<BasicValue>& args) {
+    return file_write(vm, args, true);
+}
+
+// FILE.CLOSE handle
+// Flushes and closes a file handle.
+BasicValue builtin_file_close(NeReLaBasic& vm, const std::vector<BasicValue>& args) {
+    if (args.size() != 1) {
+        Error::set(8, vm.runtime_current_line);
+        return false;
+    }
+    if (!get_file_handle(vm, args[0])) return false;
+    vm.file_handles.erase(static_cast<int>(to_double(args[0])));
+    return false;
+}
+
+namespace {
+    // Rows formatted per block (and per thread) by CSVWRITER before the text is written.
+    constexpr size_t CSV_WRITE_BLOCK_ROWS = 1 << 14;
+
+    // Appends one CSV cell. Numbers go through the to_chars formatter; text that
+    // contains the delimiter, a quote or a line break is quoted.
+    void append_csv_cell(std::string& out, const BasicValue& val, char delimiter, int precision, char decimal_point) {
+        if (std::holds_alternative<double>(val)) {
+            StringUtils::append_number(out, std::get<double>(val), precision, decimal_point);
+            return;
+        }
+        std::string text = to_string(val);
+        if (text.find_first_of(std::string{ delimiter, '"', '\n', '\r' }) == std::string::npos) {
+            out += text;
+            return;
+        }
+        out += '"';
+        for (char ch : text) {
+            if (ch == '"') out += '"';
+            out += ch;
+        }
+        out += '"';
+    }
+}
+
+// CSVWRITER filename$, array, [delimiter$], [header_array], [precision]
+// Writes a 2D array to a CSV file, with an optional header row. Numbers are written with
+// up to 'precision' decimals (default 6); a negative precision writes the shortest exact form.
 BasicValue builtin_csvwriter(NeReLaBasic& vm, const std::vector<BasicValue>& args) {
-    if (args.size() < 2 || args.size() > 4) {
+    if (args.size() < 2 || args.size() > 5) {
         Error::set(8, vm.runtime_current_line);
         return false;
     }
@@ -2801,6 +4615,8 @@ BasicValue builtin_csvwriter(NeReLaBasic& vm, const std::vector<BasicValue>& arg
             delimiter = delim_str[0];
         }
     }
+    int precision = (args.size() >= 5) ? static_cast<int>(to_double(args[4])) : 6;
+    const char decimal_point = LocaleManager::get_number_punct().decimal_point;
 
     // 2. Validate Array Shape
     if (!array_ptr || array_ptr->shape.size() != 2) {
@@ -2816,41 +4632,371 @@ BasicValue builtin_csvwriter(NeReLaBasic& vm, const std::vector<BasicValue>& arg
     }
 
     // Handle Optional Header Array ---
-    if (args.size() == 4) {
+    if (args.size() >= 4 && !(std::holds_alternative<bool>(args[3]) && !std::get<bool>(args[3]))) {
         if (!std::holds_alternative<std::shared_ptr<Array>>(args[3])) {
-            Error::set(15, vm.runtime_current_line); // Fourth arg must be an array
+            Error::set(15, vm.runtime_current_line); // Fourth arg must be an array (or FALSE for none)
             return false;
         }
         const auto& header_ptr = std::get<std::shared_ptr<Array>>(args[3]);
         if (header_ptr) {
+            std::string header_line;
             for (size_t i = 0; i < header_ptr->data.size(); ++i) {
-                outfile << to_string(header_ptr->data[i]);
+                append_csv_cell(header_line, header_ptr->data[i], delimiter, precision, decimal_point);
                 if (i < header_ptr->data.size() - 1) {
-                    outfile << delimiter;
+                    header_line += delimiter;
                 }
             }
-            outfile << '\n'; // End the header line
+            header_line += '\n'; // End the header line
+            outfile << header_line;
         }
     }
 
-    // 4. Write Data 
-    size_t rows = array_ptr->shape[0];
-    size_t cols = array_ptr->shape[1];
+    // 4. Write Data
+    // Rows are formatted block-wise into memory (one string per thread for large
+    // blocks) and every block is written with a single call.
+    const size_t rows = array_ptr->shape[0];
+    const size_t cols = array_ptr->shape[1];
+    const auto& data = array_ptr->data;
+    const size_t workers = std::max<size_t>(1, std::min<size_t>(std::thread::hardware_concurrency(), 8));
 
-    for (size_t r = 0; r < rows; ++r) {
-        for (size_t c = 0; c < cols; ++c) {
-            const BasicValue& val = array_ptr->data[r * cols + c];
-            outfile << to_string(val);
-            if (c < cols - 1) {
-                outfile << delimiter;
+    auto format_rows = [&](size_t first, size_t last, std::string& out) {
+        out.reserve((last - first) * cols * 12);
+        for (size_t r = first; r < last; ++r) {
+            for (size_t c = 0; c < cols; ++c) {
+                append_csv_cell(out, data[r * cols + c], delimiter, precision, decimal_point);
+                if (c < cols - 1) {
+                    out += delimiter;
+                }
             }
+            out += '\n';
+        }
+        };
+
+    std::vector<std::string> chunks(workers);
+    for (size_t block_start = 0; block_start < rows; block_start += CSV_WRITE_BLOCK_ROWS * workers) {
+        const size_t block_end = std::min(rows, block_start + CSV_WRITE_BLOCK_ROWS * workers);
+        const size_t block_rows = block_end - block_start;
+        const size_t used = (block_rows + CSV_WRITE_BLOCK_ROWS - 1) / CSV_WRITE_BLOCK_ROWS;
+
+        run_blocks(block_rows, used, [&](size_t w, size_t begin, size_t end) {
+            chunks[w].clear();
+            format_rows(block_start + begin, block_start + end, chunks[w]);
+            });
+        for (size_t w = 0; w < used; ++w) {
+            outfile.write(chunks[w].data(), static_cast<std::streamsize>(chunks[w].size()));
         }
-        outfile << '\n';
     }
 
+    if (!outfile) {
+        Error::set(12, vm.runtime_current_line); // File I/O Error
+    }
     return false;
 }
 
+// --- Binary Array Files (BSAVE / BLOAD) ---
+// Arrays are stored in the NumPy .npy format (version 1.0): a short text header with the
+// element type and shape, followed by the raw little-endian elements in row-major order.
+namespace {
+    static_assert(std::endian::native == std::endian::little, "BSAVE/BLOAD copy elements in native (little-endian) byte order");
+
+    constexpr std::string_view NPY_MAGIC = "\x93NUMPY";
+
+    // Elements converted per block while writing.
+    constexpr size_t NPY_WRITE_BLOCK = 1 << 16;
+    // Element count from which BLOAD converts the data in parallel.
+    constexpr size_t PARALLEL_NPY_THRESHOLD = 1 << 18;
+
+    enum class NpyType { F8, F4, I8, I4, U1, B1 };
+
+    struct NpyDtype {
+        const char* name;  // Name accepted by BSAVE
+        const char* descr; // NumPy type string in the header
+        NpyType type;
+        size_t size;
+    };
+
+    const NpyDtype NPY_DTYPES[] = {
+        {"F8", "<f8", NpyType::F8, 8},
+        {"F4", "<f4", NpyType::F4, 4},
+        {"I8", "<i8", NpyType::I8, 8},
+        {"I4", "<i4", NpyType::I4, 4},
+        {"U1", "|u1", NpyType::U1, 1},
+        {"B1", "|b1", NpyType::B1, 1},
+    };
+
+    const NpyDtype* find_npy_dtype(std::string_view key) {
+        for (const auto& dtype : NPY_DTYPES) {
+            if (key == dtype.name || key == dtype.descr) return &dtype;
+        }
+        return nullptr;
+    }
+
+    template <typename T>
+    void npy_put(char* dst, T value) { std::memcpy(dst, &value, sizeof(T)); }
+
+    template <typename T>
+    T npy_get(const char* src) {
+        T value;
+        std::memcpy(&value, src, sizeof(T));
+        return value;
+    }
+
+    // Converts to a narrower type. A plain cast is undefined for NaN and out-of-range
+    // values, so integers are clamped to their range (NaN gives 0) and floats overflow to infinity.
+    template <typename T>
+    T npy_narrow(double value) {
+        if constexpr (std::is_floating_point_v<T>) {
+            if (std::isfinite(value) && std::fabs(value) > std::numeric_limits<T>::max()) {
+                return value < 0 ? -std::numeric_limits<T>::infinity() : std::numeric_limits<T>::infinity();
+            }
+            return static_cast<T>(value);
+        }
+        else {
+            if (std::isnan(value)) return 0;
+            if (value <= static_cast<double>(std::numeric_limits<T>::min())) return std::numeric_limits<T>::min();
+            if (value >= static_cast<double>(std::numeric_limits<T>::max())) return std::numeric_limits<T>::max();
+            return static_cast<T>(value);
+        }
+    }
+
+    void npy_store(NpyType type, double value, char* dst) {
+        switch (type) {
+        case NpyType::F8: npy_put(dst, value); break;
+        case NpyType::F4: npy_put(dst, npy_narrow<float>(value)); break;
+        case NpyType::I8: npy_put(dst, npy_narrow<int64_t>(value)); break;
+        case NpyType::I4: npy_put(dst, npy_narrow<int32_t>(value)); break;
+        case NpyType::U1: npy_put(dst, npy_narrow<uint8_t>(value)); break;
+        case NpyType::B1: npy_put(dst, static_cast<uint8_t>(value != 0.0)); break;
+        }
+    }
+
+    BasicValue npy_load(NpyType type, const char* src) {
+        switch (type) {
+        case NpyType::F8: return npy_get<double>(src);
+        case NpyType::F4: return static_cast<double>(npy_get<float>(src));
+        case NpyType::I8: return static_cast<double>(npy_get<int64_t>(src));
+        case NpyType::I4: return static_cast<double>(npy_get<int32_t>(src));
+        case NpyType::U1: return static_cast<double>(npy_get<uint8_t>(src));
+        case NpyType::B1: return npy_get<uint8_t>(src) != 0;
+        }
+        return 0.0;
+    }
+
+    // Builds the complete header (magic, version, length and the padded dictionary).
+    std::string npy_header(const NpyDtype& dtype, const std::vector<size_t>& shape) {
+        std::string dict = "{'descr': '" + std::string(dtype.descr) + "', 'fortran_order': False, 'shape': (";
+        for (size_t i = 0; i < shape.size(); ++i) {
+            dict += std::to_string(shape[i]);
+            if (shape.size() == 1) dict += ',';
+            else if (i + 1 < shape.size()) dict += ", ";
+        }
+        dict += "), }";
+
+        // The data must start on a 64-byte boundary; the dictionary is padded with blanks
+        // and ends in a line break.
+        const size_t prefix = NPY_MAGIC.size() + 4;
+        dict.append((64 - (prefix + dict.size() + 1) % 64) % 64, ' ');
+        dict += '\n';
+
+        std::string header(NPY_MAGIC);
+        header += '\x01';
+        header += '\x00';
+        header += static_cast<char>(dict.size() & 0xFF);
+        header += static_cast<char>((dict.size() >> 8) & 0xFF);
+        return header + dict;
+    }
+
+    // Returns the quoted or bare value that follows 'key': in the header dictionary.
+    std::string_view npy_dict_value(std::string_view dict, std::string_view key) {
+        size_t pos = dict.find(key);
+        if (pos == std::string_view::npos) return {};
+        pos = dict.find(':', pos + key.size());
+        if (pos == std::string_view::npos) return {};
+        pos = dict.find_first_not_of(' ', pos + 1);
+        if (pos == std::string_view::npos) return {};
+
+        if (dict[pos] == '\'' || dict[pos] == '"') {
+            size_t end = dict.find(dict[pos], pos + 1);
+            return end == std::string_view::npos ? std::string_view{} : dict.substr(pos + 1, end - pos - 1);
+        }
+        if (dict[pos] == '(') {
+            size_t end = dict.find(')', pos);
+            return end == std::string_view::npos ? std::string_view{} : dict.substr(pos + 1, end - pos - 1);
+        }
+        size_t end = dict.find_first_of(",}", pos);
+        return dict.substr(pos, end == std::string_view::npos ? std::string_view::npos : end - pos);
+    }
+
+    // Parses the header of a .npy file. Returns an error message, or an empty string on success.
+    std::string parse_npy_header(std::string_view file, const NpyDtype*& dtype, std::vector<size_t>& shape, size_t& data_offset) {
+        if (file.size() < 10 || file.substr(0, NPY_MAGIC.size()) != NPY_MAGIC) {
+            return "Not a binary array file.";
+        }
+        const auto byte = [&](size_t i) { return static_cast<size_t>(static_cast<unsigned char>(file[i])); };
+        size_t header_len;
+        size_t prefix;
+        switch (file[6]) {
+        case 1:
+            header_len = byte(8) | (byte(9) << 8);
+            prefix = 10;
+            break;
+        case 2:
+        case 3:
+            if (file.size() < 12) return "Not a binary array file.";
+            header_len = byte(8) | (byte(9) << 8) | (byte(10) << 16) | (byte(11) << 24);
+            prefix = 12;
+            break;
+        default:
+            return "Unsupported binary array file version.";
+        }
+        if (prefix + header_len > file.size()) return "Binary array file is truncated.";
+        std::string_view dict = file.substr(prefix, header_len);
+        data_offset = prefix + header_len;
+
+        std::string_view descr = npy_dict_value(dict, "'descr'");
+        dtype = find_npy_dtype(descr);
+        if (!dtype) return "Unsupported element type: " + std::string(descr);
+        if (npy_dict_value(dict, "'fortran_order'") != "False") {
+            return "Column-major (Fortran order) arrays are not supported.";
+        }
+
+        shape.clear();
+        std::string_view dims = npy_dict_value(dict, "'shape'");
+        const char* p = dims.data();
+        const char* end = dims.data() + dims.size();
+        while (p < end) {
+            if (*p == ' ' || *p == ',') { ++p; continue; }
+            size_t dim = 0;
+            auto [next, ec] = std::from_chars(p, end, dim);
+            if (ec != std::errc()) return "Invalid shape in binary array file.";
+            shape.push_back(dim);
+            p = next;
+        }
+        return {};
+    }
+}
+
+// BSAVE filename$, array, [dtype$]
+// Saves a numeric array in the NumPy .npy format. dtype$ selects the element type:
+// "F8" (double, default), "F4", "I8", "I4", "U1" (byte) or "B1" (boolean). Values outside
+// an integer type's range are clamped to it.
+BasicValue builtin_bsave(NeReLaBasic& vm, const std::vector<BasicValue>& args) {
+    if (args.size() < 2 || args.size() > 3) {
+        Error::set(8, vm.runtime_current_line);
+        return false;
+    }
+    std::string filename = to_string(args[0]);
+    if (!std::holds_alternative<std::shared_ptr<Array>>(args[1])) {
+        Error::set(15, vm.runtime_current_line); // Second arg must be an array
+        return false;
+    }
+    const auto& array_ptr = std::get<std::shared_ptr<Array>>(args[1]);
+    if (!array_ptr) {
+        Error::set(15, vm.runtime_current_line);
+        return false;
+    }
+
+    const NpyDtype* dtype = &NPY_DTYPES[0];
+    if (args.size() == 3) {
+        std::string name = to_upper(to_string(args[2]));
+        dtype = find_npy_dtype(name);
+        if (!dtype) {
+            Error::set(1, vm.runtime_current_line, "Invalid element type: " + name);
+            return false;
+        }
+    }
+
+    std::ofstream outfile(filename, std::ios::binary);
+    if (!outfile) {
+        Error::set(12, vm.runtime_current_line); // File I/O Error
+        return false;
+    }
+    std::string header = npy_header(*dtype, array_ptr->shape);
+    outfile.write(header.data(), static_cast<std::streamsize>(header.size()));
+
+    // Elements are converted into a fixed-size buffer that is written block by block.
+    const auto& data = array_ptr->data;
+    std::vector<char> buffer(std::min(data.size(), NPY_WRITE_BLOCK) * dtype->size);
+    for (size_t block_start = 0; block_start < data.size(); block_start += NPY_WRITE_BLOCK) {
+        const size_t block_end = std::min(data.size(), block_start + NPY_WRITE_BLOCK);
+        char* dst = buffer.data();
+        for (size_t i = block_start; i < block_end; ++i, dst += dtype->size) {
+            const BasicValue& val = data[i];
+            double d;
+            if (std::holds_alternative<double>(val)) d = std::get<double>(val);
+            else if (std::holds_alternative<int>(val)) d = std::get<int>(val);
+            else if (std::holds_alternative<bool>(val)) d = std::get<bool>(val) ? 1.0 : 0.0;
+            else {
+                Error::set(15, vm.runtime_current_line, "BSAVE needs a numeric array.");
+                return false;
+            }
+            npy_store(dtype->type, d, dst);
+        }
+        outfile.write(buffer.data(), static_cast<std::streamsize>(dst - buffer.data()));
+    }
+
+    if (!outfile) {
+        Error::set(12, vm.runtime_current_line); // File I/O Error
+    }
+    return false;
+}
+
+// BLOAD(filename$) -> array
+// Loads an array saved by BSAVE (or by NumPy's save). The file is memory-mapped and
+// converted straight from the mapped pages; large arrays are converted in parallel.
+BasicValue builtin_bload(NeReLaBasic& vm, const std::vector<BasicValue>& args) {
+    if (args.size() != 1) {
+        Error::set(8, vm.runtime_current_line);
+        return {};
+    }
+    std::string filename = to_string(args[0]);
+
+    FileIO::MappedFile file;
+    if (!file.open(filename)) {
+        Error::set(6, vm.runtime_current_line, filename); // File not found
+        return {};
+    }
+
+    const NpyDtype* dtype = nullptr;
+    std::vector<size_t> shape;
+    size_t data_offset = 0;
+    std::string message = parse_npy_header(file.text(), dtype, shape, data_offset);
+    if (!message.empty()) {
+        Error::set(12, vm.runtime_current_line, message);
+        return {};
+    }
+
+    size_t count = 1;
+    for (size_t dim : shape) {
+        if (dim != 0 && count > SIZE_MAX / dim) {
+            Error::set(12, vm.runtime_current_line, "Binary array file has an invalid shape.");
+            return {};
+        }
+        count *= dim;
+    }
+    if (shape.empty()) shape = { 1 }; // A 0-d array is loaded as a single element
+    // Every element must be in the file, so a corrupt shape never sizes the array.
+    if (count > (file.size() - data_offset) / dtype->size) {
+        Error::set(12, vm.runtime_current_line, "Binary array file is truncated.");
+        return {};
+    }
+
+    auto result = std::make_shared<Array>();
+    result->shape = shape;
+    result->data.resize(count);
+
+    const char* src = file.data() + data_offset;
+    const NpyType type = dtype->type;
+    const size_t size = dtype->size;
+    const size_t workers = count < PARALLEL_NPY_THRESHOLD ? 1 : worker_count(count, PARALLEL_NPY_THRESHOLD / 4);
+    run_blocks(count, workers, [&](size_t, size_t begin, size_t end) {
+        for (size_t i = begin; i < end; ++i) {
+            result->data[i] = npy_load(type, src + i * size);
+        }
+        });
+    return result;
+}
+
 // --- GUI and Graphic and more ---
 // Handles: COLOR fg, bg
 BasicValue builtin_color(NeReLaBasic& vm, const std::vector<BasicValue>& args) {
@@ -2987,13 +5133,18 @@ void register_builtin_functions(NeReLaBasic& vm, NeReLaBasic::FunctionTable& tab
     register_func("ASC", 1, builtin_asc);
     register_func("CHR$", 1, builtin_chr_str);
     register_func("INSTR", -1, builtin_instr); // -1 for variable args
+    register_func("INSTRANY", -1, builtin_instrany);
     register_func("LCASE$", 1, builtin_lcase_str);
     register_func("UCASE$", 1, builtin_ucase_str);
     register_func("TRIM$", 1, builtin_trim_str);
     register_func("INKEY$", 0, builtin_inkey);
     register_func("VAL", 1, builtin_val);
     register_func("STR$", 1, builtin_str_str);
-    register_func("SPLIT", 2, builtin_split);
+    register_func("SPLIT", -1, builtin_split); // -1 for optional max_parts and is_regex
+    register_func("REGEX.MATCH", 2, builtin_regex_match);
+    register_func("REGEX.FIND", 2, builtin_regex_find);
+    register_func("REGEX.REPLACE$", 3, builtin_regex_replace_str);
+    register_func("REGEX.SPLIT", -1, builtin_regex_split);
     register_func("FRMV$", 1, builtin_frmv_str);
     register_func("FORMAT$", -1, builtin_format_str);
 
@@ -3016,9 +5167,13 @@ void register_builtin_functions(NeReLaBasic& vm, NeReLaBasic::FunctionTable& tab
     register_func("MAX", -1, builtin_max);
     register_func("ANY", -1, builtin_any);
     register_func("ALL", -1, builtin_all);
+    register_func("SCAN", -1, builtin_scan);
+    register_func("APPLY", 2, builtin_apply);
+    register_func("FILTER", 2, builtin_filter);
+    register_func("REDUCE", -1, builtin_reduce);
     register_func("MATMUL", 2, builtin_matmul);
     register_func("OUTER", 3, builtin_outer);
-    register_func("INTEGRATE", 3, builtin_integrate);
+    register_func("INTEGRATE", -1, builtin_integrate);
     register_func("SOLVE", 2, builtin_solve);
     register_func("INVERT", 1, builtin_invert);
     register_func("TAKE", 2, builtin_take);
@@ -3074,6 +5229,18 @@ void register_builtin_functions(NeReLaBasic& vm, NeReLaBasic::FunctionTable& tab
 
     register_func("JSON.PARSE$", 1, builtin_json_parse);
     register_func("JSON.STRINGIFY$", 1, builtin_json_stringify);
+    register_func("JSON.OPEN", 1, builtin_json_open);
+    register_func("JSON.NEXT", 1, builtin_json_next);
+    register_func("JSON.EOF", 1, builtin_json_eof);
+    register_proc("JSON.CLOSE", 1, builtin_json_close);
+    register_func("JSON.SELECT", 2, builtin_json_select);
+
+    register_func("STRINGBUILDER", -1, builtin_stringbuilder);
+    register_proc("SB.APPEND", -1, builtin_sb_append);
+    register_func("SB.TOSTRING$", 1, builtin_sb_tostring_str);
+    register_func("SB.LEN", 1, builtin_sb_len);
+    register_proc("SB.CLEAR", 1, builtin_sb_clear);
+    register_proc("SB.FREE", 1, builtin_sb_free);
 
     register_func("MAP.EXISTS", 2, builtin_map_exists);
     register_func("MAP.KEYS", 1, builtin_map_keys);
@@ -3095,8 +5262,22 @@ void register_builtin_functions(NeReLaBasic& vm, NeReLaBasic::FunctionTable& tab
     register_proc("KILL", 1, builtin_kill);
 
     register_func("CSVREADER", -1, builtin_csvreader); // -1 for optional args
+    register_func("CSVOPEN", -1, builtin_csvopen);
+    register_func("CSVNEXT", 2, builtin_csvnext);
+    register_func("CSVEOF", 1, builtin_csveof);
+    register_proc("CSVCLOSE", 1, builtin_csvclose);
+    register_func("TABLEREAD", -1, builtin_tableread);
     register_func("TXTREADER$", 1, builtin_txtreader_str);
     register_proc("TXTWRITER", 2, builtin_txtwriter);
-    register_proc("CSVWRITER", -1, builtin_csvwriter); // -1 for optional delimiter
+    register_proc("CSVWRITER", -1, builtin_csvwriter); // -1 for optional delimiter, header and precision
+
+    register_func("FILE.OPEN", -1, builtin_file_open);
+    register_func("FILE.READLINE$", 1, builtin_file_readline_str);
+    register_func("FILE.EOF", 1, builtin_file_eof);
+    register_proc("FILE.WRITE", 2, builtin_file_write);
+    register_proc("FILE.WRITELINE", 2, builtin_file_writeline);
+    register_proc("FILE.CLOSE", 1, builtin_file_close);
+    register_proc("BSAVE", -1, builtin_bsave); // -1 for optional dtype
+    register_func("BLOAD", 1, builtin_bload);
 
 }
\ No newline at end of file
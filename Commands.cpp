@@ -39,27 +39,33 @@ namespace { // Use an anonymous namespace to keep this helper local to this file
     }
 
     std::string array_to_string_recursive(const Array& arr, size_t& data_index, size_t current_dimension) {
-        std::stringstream ss;
-        ss << "[";
+        std::string out = "[";
 
         bool is_innermost_vector = (current_dimension == arr.shape.size() - 1);
 
         for (size_t i = 0; i < arr.shape[current_dimension]; ++i) {
             if (is_innermost_vector) {
                 if (data_index < arr.data.size()) {
-                    ss << value_to_string_for_array(arr.data[data_index++]);
+                    const BasicValue& element = arr.data[data_index++];
+                    if (std::holds_alternative<double>(element)) {
+                        // Numbers are appended in place instead of through a temporary string
+                        LocaleManager::append_number(out, std::get<double>(element));
+                    }
+                    else {
+                        out += value_to_string_for_array(element);
+                    }
                 }
             }
             else {
-                ss << array_to_string_recursive(arr, data_index, current_dimension + 1);
+                out += array_to_string_recursive(arr, data_index, current_dimension + 1);
             }
 
             if (i < arr.shape[current_dimension] - 1) {
-                ss << " "; // Separator between elements/sub-arrays
+                out += ' '; // Separator between elements/sub-arrays
             }
         }
-        ss << "]";
-        return ss.str();
+        out += ']';
+        return out;
     }
 } // end anonymous namespace
 
@@ -100,30 +106,30 @@ BasicValue& get_variable(NeReLaBasic& vm, const std::string& name) {
 
 // Sets a variable. If inside a function, it sets the variable in the
 // CURRENT function's local scope. Otherwise, it sets a global variable.
-void set_variable(NeReLaBasic& vm, const std::string& name, const BasicValue& value) {
+void set_variable(NeReLaBasic& vm, const std::string& name, BasicValue value) {
     // If we are inside a function/subroutine...
     if (!vm.call_stack.empty()) {
         // First, check if a LOCAL variable with this name already exists in the current scope.
         // This is important for loops or multiple assignments to the same local variable.
         if (vm.call_stack.back().local_variables.count(name)) {
-            vm.call_stack.back().local_variables[name] = value;
+            vm.call_stack.back().local_variables[name] = std::move(value);
             return;
         }
 
         // Second, check if a GLOBAL variable with this name exists.
         // If so, update the global one INSTEAD of creating a new local one.
         if (vm.variables.count(name)) {
-            vm.variables[name] = value;
+            vm.variables[name] = std::move(value);
             return;
         }
 
         // Finally, if it's not in the local scope and not in the global scope,
         // it is a brand new variable, which we will define as local to the subroutine.
-        vm.call_stack.back().local_variables[name] = value;
+        vm.call_stack.back().local_variables[name] = std::move(value);
     }
     else {
         // Not in a subroutine, so it must be a global variable.
-        vm.variables[name] = value;
+        vm.variables[name] = std::move(value);
     }
 }
 
@@ -138,24 +144,16 @@ std::string to_string(const BasicValue& val) {
             return arg ? "TRUE" : "FALSE";
         }
         else if constexpr (std::is_same_v<T, double>) {
-            std::stringstream ss;
-            // Get the current locale from our global manager
-            ss.imbue(LocaleManager::get_current_locale());
-            ss << std::fixed << std::setprecision(6) << arg;
-
-            std::string s = ss.str();
-            s.erase(s.find_last_not_of('0') + 1, std::string::npos);
-            char decimal_point = std::use_facet<std::numpunct<char>>(LocaleManager::get_current_locale()).decimal_point();
-            if (!s.empty() && s.back() == decimal_point) {
-                s.pop_back();
-            }
+            // Formatted with to_chars and the cached locale punctuation; short numbers
+            // fit the string's inline buffer, so no heap allocation is needed.
+            std::string s;
+            LocaleManager::append_number(s, arg);
             return s;
         }
         else if constexpr (std::is_same_v<T, int>) {
-            std::stringstream ss;
-            ss.imbue(LocaleManager::get_current_locale());
-            ss << arg;
-            return ss.str();
+            std::string s;
+            LocaleManager::append_number(s, static_cast<long long>(arg));
+            return s;
         }
         else if constexpr (std::is_same_v<T, std::string>) {
             return arg;
@@ -229,6 +227,23 @@ std::string to_string(const BasicValue& val) {
         }, val);
 }
 
+std::string_view to_key_view(const BasicValue& val, std::string& buffer) {
+    if (const auto* str = std::get_if<std::string>(&val)) {
+        return *str;
+    }
+    buffer.clear();
+    if (const auto* num = std::get_if<double>(&val)) {
+        LocaleManager::append_number(buffer, *num);
+    }
+    else if (const auto* num = std::get_if<int>(&val)) {
+        LocaleManager::append_number(buffer, static_cast<long long>(*num));
+    }
+    else {
+        buffer = to_string(val);
+    }
+    return buffer;
+}
+
 void print_value(const BasicValue& val) {
     TextIO::print(to_string(val));
 }
@@ -430,6 +445,7 @@ void Commands::do_input(NeReLaBasic& vm) {
 
     // Read a full line of input from the user.
     std::string user_input_line;
+    TextIO::flush(); // The prompt must be visible before we wait
     std::getline(std::cin, user_input_line);
 
     // Store the value, converting type if necessary.
@@ -438,14 +454,11 @@ void Commands::do_input(NeReLaBasic& vm) {
         set_variable(vm, var_name, user_input_line);
     }
     else {
-        // It's a numeric variable. Try to convert the input to a double.
-        try {
-            double num_val = std::stod(user_input_line);
-            set_variable(vm, var_name, num_val);
-        }
-        catch (const std::exception&) {
-            set_variable(vm, var_name, 0.0);
-        }
+        // It's a numeric variable. Read the input the way VAL does; no number gives 0.
+        const auto& punct = LocaleManager::get_number_punct();
+        double num_val = 0.0;
+        if (!StringUtils::parse_number(user_input_line, num_val, punct.decimal_point, punct.thousands_sep)) num_val = 0.0;
+        set_variable(vm, var_name, num_val);
     }
 }
 void Commands::do_print(NeReLaBasic& vm) {
@@ -492,6 +505,145 @@ void Commands::do_print(NeReLaBasic& vm) {
     }
 }
 
+// Returns the variable that both reading and assigning 'name' refer to, or nullptr if
+// it does not exist yet or an assignment would create a new local instead.
+static BasicValue* find_assigned_variable(NeReLaBasic& vm, const std::string& name) {
+    for (auto it = vm.call_stack.rbegin(); it != vm.call_stack.rend(); ++it) {
+        auto var_it = it->local_variables.find(name);
+        if (var_it != it->local_variables.end()) {
+            return it == vm.call_stack.rbegin() ? &var_it->second : nullptr;
+        }
+    }
+    auto var_it = vm.variables.find(name);
+    return var_it != vm.variables.end() ? &var_it->second : nullptr;
+}
+
+// True if evaluating the rest of the statement from p-code offset 'pos' could run BASIC
+// code: a call of a user function, a function reference, or anything not recognized.
+// Such code could reassign the variable, so the expression must read it first.
+static bool expression_may_call_user_code(NeReLaBasic& vm, size_t pos) {
+    const auto& code = *vm.active_p_code;
+    auto read_name = [&]() {
+        const size_t begin = pos;
+        while (pos < code.size() && code[pos] != 0) ++pos;
+        std::string name(code.begin() + begin, code.begin() + pos);
+        ++pos; // Null terminator
+        return name;
+    };
+
+    while (pos < code.size()) {
+        const Tokens::ID token = static_cast<Tokens::ID>(code[pos++]);
+        switch (token) {
+        case Tokens::ID::C_CR: case Tokens::ID::C_COLON: case Tokens::ID::NOCMD: case Tokens::ID::ELSE:
+            return false; // End of the statement
+        case Tokens::ID::AND: case Tokens::ID::OR: case Tokens::ID::NOT: case Tokens::ID::MOD:
+        case Tokens::ID::JD_TRUE: case Tokens::ID::JD_FALSE: case Tokens::ID::C_COMMA:
+        case Tokens::ID::C_PLUS: case Tokens::ID::C_MINUS: case Tokens::ID::C_ASTR: case Tokens::ID::C_SLASH:
+        case Tokens::ID::C_MOD: case Tokens::ID::C_CARET: case Tokens::ID::C_LEFTPAREN: case Tokens::ID::C_RIGHTPAREN:
+        case Tokens::ID::C_LEFTBRACKET: case Tokens::ID::C_RIGHTBRACKET: case Tokens::ID::C_LEFTBRACE:
+        case Tokens::ID::C_RIGHTBRACE: case Tokens::ID::C_DOT: case Tokens::ID::C_LT: case Tokens::ID::C_GT:
+        case Tokens::ID::C_EQ: case Tokens::ID::C_NE: case Tokens::ID::C_LE: case Tokens::ID::C_GE:
+            break;
+        case Tokens::ID::NUMBER:
+            pos += sizeof(double);
+            break;
+        case Tokens::ID::STRING: case Tokens::ID::STRVAR: case Tokens::ID::CONSTANT:
+        case Tokens::ID::ARRAY_ACCESS: case Tokens::ID::MAP_ACCESS:
+            read_name();
+            break;
+        case Tokens::ID::VARIANT: {
+            // A variable holding a function reference can be handed to APPLY, REDUCE, ...
+            const std::string var_name = to_upper(read_name());
+            const BasicValue* value = nullptr;
+            if (!vm.call_stack.empty()) {
+                auto local_it = vm.call_stack.back().local_variables.find(var_name);
+                if (local_it != vm.call_stack.back().local_variables.end()) value = &local_it->second;
+            }
+            if (!value) {
+                auto var_it = vm.variables.find(var_name);
+                if (var_it != vm.variables.end()) value = &var_it->second;
+            }
+            if (value && std::holds_alternative<FunctionRef>(*value)) return true;
+            break;
+        }
+        case Tokens::ID::CALLFUNC: {
+            // Only builtins are safe; they never assign BASIC variables.
+            auto func_it = vm.active_function_table->find(to_upper(read_name()));
+            if (func_it == vm.active_function_table->end() || !func_it->second.native_impl) return true;
+            break;
+        }
+        default:
+            return true; // FUNCREF, or a token this scan does not know
+        }
+    }
+    return false;
+}
+
+// Handles NAME = NAME + a + b ... for a string variable. The operands are evaluated
+// first (they cannot call BASIC code, so NAME still reads as its old value) and then appended to the variable's own
+// buffer, which makes building a long string in a loop linear instead of quadratic.
+// Returns false with pcode untouched if the statement has a different shape.
+static bool append_in_place(NeReLaBasic& vm, const std::string& name) {
+    const uint16_t start = vm.pcode;
+    Tokens::ID token = static_cast<Tokens::ID>((*vm.active_p_code)[vm.pcode]);
+    if (token != Tokens::ID::STRVAR && token != Tokens::ID::VARIANT) return false;
+    vm.pcode++;
+    if (to_upper(read_string(vm)) != name || static_cast<Tokens::ID>((*vm.active_p_code)[vm.pcode]) != Tokens::ID::C_PLUS ||
+        expression_may_call_user_code(vm, vm.pcode)) {
+        vm.pcode = start;
+        return false;
+    }
+    BasicValue* target = find_assigned_variable(vm, name);
+    if (!target || !std::holds_alternative<std::string>(*target)) {
+        vm.pcode = start;
+        return false;
+    }
+
+    std::vector<BasicValue> parts;
+    while (static_cast<Tokens::ID>((*vm.active_p_code)[vm.pcode]) == Tokens::ID::C_PLUS) {
+        vm.pcode++;
+        parts.push_back(vm.parse_factor());
+        if (Error::get() != 0) return true;
+        if (std::holds_alternative<std::shared_ptr<Array>>(parts.back())) break;
+    }
+
+    // An array operand, '-', a comparison or AND/OR: finish the expression the normal way,
+    // starting from the operands already evaluated.
+    const Tokens::ID next = static_cast<Tokens::ID>((*vm.active_p_code)[vm.pcode]);
+    const bool ends_here = !std::holds_alternative<std::shared_ptr<Array>>(parts.back()) &&
+        next != Tokens::ID::C_MINUS && next != Tokens::ID::C_EQ && next != Tokens::ID::C_NE &&
+        next != Tokens::ID::C_LT && next != Tokens::ID::C_GT && next != Tokens::ID::C_LE &&
+        next != Tokens::ID::C_GE && next != Tokens::ID::AND && next != Tokens::ID::OR;
+    // No BASIC code ran, so the variable still holds its old value, but builtins may have
+    // added variables since; look it up again.
+    target = find_assigned_variable(vm, name);
+    if (!ends_here) {
+        BasicValue left = std::string();
+        if (target) left = std::holds_alternative<std::string>(*target) ? *target : BasicValue(to_string(*target));
+        for (const auto& part : parts) {
+            if (std::holds_alternative<std::shared_ptr<Array>>(part)) left = vm.apply_array_arithmetic(Tokens::ID::C_PLUS, left, part);
+            else std::get<std::string>(left) += to_string(part);
+        }
+        left = vm.continue_expression(std::move(left));
+        if (Error::get() != 0) return true;
+        set_variable(vm, name, std::move(left));
+        return true;
+    }
+
+    if (!target || !std::holds_alternative<std::string>(*target)) {
+        BasicValue left = target ? BasicValue(to_string(*target)) : BasicValue(std::string());
+        for (const auto& part : parts) std::get<std::string>(left) += to_string(part);
+        set_variable(vm, name, std::move(left));
+        return true;
+    }
+    std::string& text = std::get<std::string>(*target);
+    for (const auto& part : parts) {
+        if (const auto* more = std::get_if<std::string>(&part)) text += *more;
+        else text += to_string(part);
+    }
+    return true;
+}
+
 void Commands::do_let(NeReLaBasic& vm) {
     Tokens::ID var_type_token = static_cast<Tokens::ID>((*vm.active_p_code)[vm.pcode]);
     vm.pcode++;
@@ -551,7 +703,8 @@ void Commands::do_let(NeReLaBasic& vm) {
         // The key inside {} must be a string expression
         BasicValue key_val = vm.evaluate_expression();
         if (Error::get() != 0) return;
-        std::string key = to_string(key_val);
+        std::string key_buffer;
+        std::string_view key = to_key_view(key_val, key_buffer);
 
         if (static_cast<Tokens::ID>((*vm.active_p_code)[vm.pcode++]) != Tokens::ID::C_RIGHTBRACE) {
             Error::set(1, vm.runtime_current_line); return;
@@ -570,8 +723,8 @@ void Commands::do_let(NeReLaBasic& vm) {
         const auto& map_ptr = std::get<std::shared_ptr<Map>>(map_var);
         if (!map_ptr) { Error::set(15, vm.runtime_current_line); return; }
 
-        // Perform the map insertion/update
-        map_ptr->data[key] = value_to_assign;
+        // Perform the map insertion/update with a single probe, moving the value in
+        map_ptr->data[key] = std::move(value_to_assign);
     }
     // --- Case 3: WHOLE VARIABLE ASSIGNMENT (e.g., A = ...) ---
     else {
@@ -590,7 +743,7 @@ void Commands::do_let(NeReLaBasic& vm) {
             if (std::holds_alternative<std::shared_ptr<Map>>(final_obj)) {
                 auto& map_ptr = std::get<std::shared_ptr<Map>>(final_obj);
                 if (map_ptr) {
-                    map_ptr->data[final_member] = value_to_assign;
+                    map_ptr->data[final_member] = std::move(value_to_assign);
                 }
                 else {
                     Error::set(3, vm.runtime_current_line, "Cannot assign to member of a null object.");
@@ -619,9 +772,10 @@ void Commands::do_let(NeReLaBasic& vm) {
             if (static_cast<Tokens::ID>((*vm.active_p_code)[vm.pcode++]) != Tokens::ID::C_EQ) {
                 Error::set(1, vm.runtime_current_line); return;
             }
+            if (append_in_place(vm, name)) return;
             BasicValue value_to_assign = vm.evaluate_expression();
             if (Error::get() != 0) return;
-            set_variable(vm, name, value_to_assign);
+            set_variable(vm, name, std::move(value_to_assign));
         }
     }
 }
@@ -1305,6 +1459,7 @@ void Commands::do_stop(NeReLaBasic& vm) {
         // We must clear any error from the previous debug command.
         Error::clear();
         TextIO::print("Ready (paused)\n? ");
+        TextIO::flush();
 
         if (!std::getline(std::cin, inputLine)) {
             paused = false;
@@ -1372,6 +1527,7 @@ void Commands::do_run(NeReLaBasic& vm) {
     vm.variables.clear();
     vm.call_stack.clear();
     vm.for_stack.clear();
+    vm.close_program_resources();
     Error::clear();
     vm.is_stopped = false; // Reset the stopped state
 
@@ -1386,6 +1542,8 @@ void Commands::do_run(NeReLaBasic& vm) {
     if (Error::get() != 0) {
         Error::print();
     }
+    // A STOPped program keeps its files open for RESUME.
+    if (!vm.is_stopped) vm.close_program_resources();
     vm.active_function_table = &vm.main_function_table;
 }
 
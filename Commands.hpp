@@ -42,8 +42,11 @@ namespace Commands {
 }
 
 BasicValue& get_variable(NeReLaBasic& vm, const std::string& name);
-void set_variable(NeReLaBasic& vm, const std::string& name, const BasicValue& value);
+void set_variable(NeReLaBasic& vm, const std::string& name, BasicValue value);
 std::string to_string(const BasicValue& val);
+// Returns the text of a value used as a map key. String keys are viewed in place; numbers
+// are formatted into 'buffer', which must outlive the returned view.
+std::string_view to_key_view(const BasicValue& val, std::string& buffer);
 std::string to_upper(std::string s);
 std::string read_string(NeReLaBasic& vm);
 
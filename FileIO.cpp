@@ -0,0 +1,679 @@
+// FileIO.cpp
+#include "FileIO.hpp"
+#include <algorithm>
+#include <atomic>
+#include <charconv>
+#include <cstring>
+#include <thread>
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace {
+    // Batches with at least this many records are parsed on several threads.
+    constexpr size_t PARALLEL_PARSE_RECORDS = 4096;
+
+    // Size of the read and write buffers of a TextFile.
+    constexpr size_t TEXTFILE_BUFFER_SIZE = 1 << 16;
+
+    // Drops a trailing '\r' so CRLF files parse like LF files.
+    std::string_view strip_cr(std::string_view record) {
+        if (!record.empty() && record.back() == '\r') record.remove_suffix(1);
+        return record;
+    }
+
+    std::string_view trim_blanks(std::string_view s) {
+        while (!s.empty() && (s.front() == ' ' || s.front() == '\t')) s.remove_prefix(1);
+        while (!s.empty() && (s.back() == ' ' || s.back() == '\t')) s.remove_suffix(1);
+        return s;
+    }
+}
+
+namespace FileIO {
+
+    // --- MappedFile ---
+
+    MappedFile::~MappedFile() {
+        close();
+    }
+
+    bool MappedFile::open(const std::string& filename) {
+        close();
+#ifdef _WIN32
+        HANDLE file = CreateFileA(filename.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr,
+            OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL | FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+        if (file == INVALID_HANDLE_VALUE) return false;
+
+        LARGE_INTEGER file_size;
+        if (!GetFileSizeEx(file, &file_size)) {
+            CloseHandle(file);
+            return false;
+        }
+        file_handle = file;
+        length = static_cast<size_t>(file_size.QuadPart);
+        opened = true;
+        if (length == 0) return true; // Empty files cannot be mapped, but are valid.
+
+        HANDLE mapping = CreateFileMappingA(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+        if (!mapping) {
+            close();
+            return false;
+        }
+        mapping_handle = mapping;
+        view = static_cast<const char*>(MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0));
+        if (!view) {
+            close();
+            return false;
+        }
+        return true;
+#else
+        fd = ::open(filename.c_str(), O_RDONLY);
+        if (fd < 0) return false;
+
+        struct stat st;
+        if (fstat(fd, &st) != 0) {
+            close();
+            return false;
+        }
+        length = static_cast<size_t>(st.st_size);
+        opened = true;
+        if (length == 0) return true;
+
+        void* mapped = mmap(nullptr, length, PROT_READ, MAP_PRIVATE, fd, 0);
+        if (mapped == MAP_FAILED) {
+            close();
+            return false;
+        }
+        madvise(mapped, length, MADV_SEQUENTIAL);
+        view = static_cast<const char*>(mapped);
+        return true;
+#endif
+    }
+
+    void MappedFile::close() {
+#ifdef _WIN32
+        if (view) UnmapViewOfFile(view);
+        if (mapping_handle) CloseHandle(static_cast<HANDLE>(mapping_handle));
+        if (file_handle) CloseHandle(static_cast<HANDLE>(file_handle));
+        mapping_handle = nullptr;
+        file_handle = nullptr;
+#else
+        if (view) munmap(const_cast<char*>(view), length);
+        if (fd >= 0) ::close(fd);
+        fd = -1;
+#endif
+        view = nullptr;
+        length = 0;
+        opened = false;
+    }
+
+    // --- TextFile ---
+
+    TextFile::~TextFile() {
+        close();
+    }
+
+    bool TextFile::open(const std::string& filename, Mode mode) {
+        close();
+        const char* fmode = (mode == Mode::Read) ? "rb" : (mode == Mode::Write) ? "wb" : "ab";
+#pragma warning(suppress : 4996) // fopen is fine here, the handle is owned by this object
+        fp = std::fopen(filename.c_str(), fmode);
+        if (!fp) return false;
+
+        open_mode = mode;
+        if (mode == Mode::Read) {
+            buffer.resize(TEXTFILE_BUFFER_SIZE);
+            std::setvbuf(fp, nullptr, _IONBF, 0); // We buffer ourselves
+        }
+        else {
+            std::setvbuf(fp, nullptr, _IOFBF, TEXTFILE_BUFFER_SIZE);
+        }
+        return true;
+    }
+
+    void TextFile::close() {
+        if (fp) std::fclose(fp);
+        fp = nullptr;
+        buffer.clear();
+        buf_pos = 0;
+        buf_len = 0;
+    }
+
+    bool TextFile::fill() {
+        if (!fp || open_mode != Mode::Read) return false;
+        buf_pos = 0;
+        buf_len = std::fread(buffer.data(), 1, buffer.size(), fp);
+        return buf_len > 0;
+    }
+
+    bool TextFile::eof() {
+        return buf_pos >= buf_len && !fill();
+    }
+
+    bool TextFile::read_line(std::string& line) {
+        line.clear();
+        if (eof()) return false;
+
+        while (true) {
+            const char* start = buffer.data() + buf_pos;
+            const char* nl = static_cast<const char*>(std::memchr(start, '\n', buf_len - buf_pos));
+            if (nl) {
+                line.append(start, nl);
+                buf_pos = static_cast<size_t>(nl - buffer.data()) + 1;
+                break;
+            }
+            // No line break in the rest of the buffer: keep it and read more.
+            line.append(start, buf_len - buf_pos);
+            buf_pos = buf_len;
+            if (!fill()) break; // Last line without a terminator
+        }
+        if (!line.empty() && line.back() == '\r') line.pop_back();
+        return true;
+    }
+
+    bool TextFile::write(std::string_view text) {
+        if (!fp || open_mode == Mode::Read) return false;
+        return std::fwrite(text.data(), 1, text.size(), fp) == text.size();
+    }
+
+    // --- Delimited text helpers ---
+
+    size_t find_record_end(std::string_view text, size_t pos) {
+        const char* base = text.data();
+        const size_t size = text.size();
+        if (pos >= size) return size;
+
+        // Fast path: find the next newline and only fall back to a quote-aware
+        // scan if the line actually contains a quote.
+        const char* nl = static_cast<const char*>(std::memchr(base + pos, '\n', size - pos));
+        size_t end = nl ? static_cast<size_t>(nl - base) : size;
+        if (!std::memchr(base + pos, '"', end - pos)) return end;
+
+        bool in_quotes = false;
+        for (size_t i = pos; i < size; ++i) {
+            if (base[i] == '"') in_quotes = !in_quotes;
+            else if (base[i] == '\n' && !in_quotes) return i;
+        }
+        return size;
+    }
+
+    void split_record(std::string_view record, char delimiter, std::vector<std::string_view>& fields, size_t max_fields) {
+        fields.clear();
+        size_t i = 0;
+        const size_t n = record.size();
+        while (fields.size() < max_fields) {
+            size_t start = i;
+            if (i < n && record[i] == '"') {
+                // Quoted field: skip to the closing quote ("" is an escaped quote).
+                ++i;
+                while (i < n) {
+                    if (record[i] == '"') {
+                        if (i + 1 < n && record[i + 1] == '"') { i += 2; continue; }
+                        ++i;
+                        break;
+                    }
+                    ++i;
+                }
+            }
+            while (i < n && record[i] != delimiter) ++i;
+            fields.push_back(record.substr(start, i - start));
+            if (i >= n) break;
+            ++i; // Skip the delimiter
+        }
+    }
+
+    std::string unquote_field(std::string_view field) {
+        field = trim_blanks(field);
+        if (field.size() < 2 || field.front() != '"' || field.back() != '"') return std::string(field);
+
+        std::string result;
+        result.reserve(field.size() - 2);
+        for (size_t i = 1; i + 1 < field.size(); ++i) {
+            result += field[i];
+            if (field[i] == '"' && field[i + 1] == '"') ++i;
+        }
+        return result;
+    }
+
+    bool parse_double(std::string_view field, double& out, bool whole_field) {
+        field = trim_blanks(field);
+        if (field.size() >= 2 && field.front() == '"' && field.back() == '"') {
+            field = trim_blanks(field.substr(1, field.size() - 2));
+        }
+        if (!field.empty() && field.front() == '+') field.remove_prefix(1); // from_chars rejects '+'
+
+        const char* last = field.data() + field.size();
+        auto [ptr, ec] = std::from_chars(field.data(), last, out);
+        return ec == std::errc() && ptr != field.data() && (!whole_field || ptr == last);
+    }
+
+    // --- CsvReader ---
+
+    bool CsvReader::open(const std::string& filename, char delim, bool has_header) {
+        close();
+        if (!file.open(filename)) return false;
+        delimiter = delim;
+
+        const std::string_view text = file.text();
+        if (text.size() >= 3 && std::memcmp(text.data(), "\xEF\xBB\xBF", 3) == 0) pos = 3; // Skip UTF-8 BOM
+
+        if (has_header && !at_end()) {
+            size_t end = find_record_end(text, pos);
+            std::vector<std::string_view> fields;
+            split_record(strip_cr(text.substr(pos, end - pos)), delimiter, fields);
+            for (const auto& field : fields) header_names.push_back(unquote_field(field));
+            pos = end + 1;
+        }
+        skip_empty_records();
+        return true;
+    }
+
+    void CsvReader::close() {
+        file.close();
+        pos = 0;
+        column_count = 0;
+        header_names.clear();
+        selected_columns.clear();
+    }
+
+    void CsvReader::select_columns(std::vector<size_t> columns) {
+        selected_columns = std::move(columns);
+    }
+
+    bool CsvReader::next_fields(std::vector<std::string_view>& fields) {
+        const std::string_view text = file.text();
+        while (pos < text.size()) {
+            size_t end = find_record_end(text, pos);
+            std::string_view record = strip_cr(text.substr(pos, end - pos));
+            pos = end + 1;
+            if (!record.empty()) {
+                split_record(record, delimiter, fields);
+                skip_empty_records();
+                return true;
+            }
+        }
+        return false;
+    }
+
+    void CsvReader::index_records(size_t max_rows, std::vector<std::pair<size_t, size_t>>& records) {
+        const std::string_view text = file.text();
+        while (pos < text.size() && (max_rows == 0 || records.size() < max_rows)) {
+            size_t end = find_record_end(text, pos);
+            std::string_view record = strip_cr(text.substr(pos, end - pos));
+            if (!record.empty()) records.emplace_back(pos, pos + record.size());
+            pos = end + 1;
+        }
+        skip_empty_records();
+    }
+
+    void CsvReader::skip_empty_records() {
+        const std::string_view text = file.text();
+        while (pos < text.size()) {
+            size_t end = find_record_end(text, pos);
+            if (!strip_cr(text.substr(pos, end - pos)).empty()) break;
+            pos = end + 1;
+        }
+    }
+
+    bool CsvReader::read_numeric(size_t max_rows, std::vector<BasicValue>& out, size_t& rows, size_t& cols) {
+        std::vector<std::pair<size_t, size_t>> records;
+        index_records(max_rows, records);
+
+        const std::string_view text = file.text();
+        rows = records.size();
+        if (rows == 0) {
+            cols = column_count;
+            return true;
+        }
+
+        // The first data record fixes the column count for the whole file.
+        if (column_count == 0) {
+            std::vector<std::string_view> fields;
+            split_record(text.substr(records[0].first, records[0].second - records[0].first), delimiter, fields);
+            column_count = fields.size();
+        }
+
+        // With a column selection only the cells up to the last selected column are
+        // split, and a record only needs to be long enough to contain them.
+        const bool selecting = !selected_columns.empty();
+        const size_t needed = selecting ? *std::max_element(selected_columns.begin(), selected_columns.end()) + 1 : column_count;
+        cols = selecting ? selected_columns.size() : column_count;
+
+        // Pre-size the output so every worker writes its rows in place.
+        const size_t base = out.size();
+        out.resize(base + rows * cols);
+
+        std::atomic<bool> ragged{ false };
+        auto parse_rows = [&](size_t first, size_t last) {
+            std::vector<std::string_view> fields;
+            for (size_t r = first; r < last && !ragged; ++r) {
+                std::string_view record = text.substr(records[r].first, records[r].second - records[r].first);
+                split_record(record, delimiter, fields, selecting ? needed : SIZE_MAX);
+                if (selecting ? fields.size() < needed : fields.size() != cols) { ragged = true; return; }
+                BasicValue* dest = out.data() + base + r * cols;
+                for (size_t c = 0; c < cols; ++c) {
+                    double value;
+                    const std::string_view cell = fields[selecting ? selected_columns[c] : c];
+                    dest[c] = parse_double(cell, value) ? value : 0.0; // Non-numeric cells become 0.0
+                }
+            }
+            };
+
+        size_t workers = 1;
+        if (rows >= PARALLEL_PARSE_RECORDS) {
+            workers = std::max<size_t>(1, std::min<size_t>(std::thread::hardware_concurrency(), rows / (PARALLEL_PARSE_RECORDS / 4)));
+        }
+        if (workers <= 1) {
+            parse_rows(0, rows);
+        }
+        else {
+            const size_t block = (rows + workers - 1) / workers;
+            std::vector<std::thread> pool;
+            for (size_t w = 0; w < workers; ++w) {
+                size_t first = w * block;
+                size_t last = std::min(rows, first + block);
+                if (first < last) pool.emplace_back(parse_rows, first, last);
+            }
+            for (auto& t : pool) t.join();
+        }
+
+        if (ragged) {
+            out.resize(base);
+            return false;
+        }
+        return true;
+    }
+
+    // --- Streaming JSON ---
+
+    namespace {
+        constexpr int END_OF_STREAM = std::char_traits<char>::eof();
+
+        // Skips JSON whitespace and returns the next character without consuming it.
+        int skip_json_space(std::streambuf& sb) {
+            int c = sb.sgetc();
+            while (c == ' ' || c == '\t' || c == '\r' || c == '\n') c = sb.snextc();
+            return c;
+        }
+
+        // Reads a number that starts at the current position. The parser is not used for
+        // numbers outside a container: its lexer consumes the character after a number,
+        // which would swallow the ',' or ']' that follows an array element.
+        bool read_json_number(std::streambuf& sb, nlohmann::json& value, std::string& error) {
+            std::string token;
+            for (int c = sb.sgetc(); c != END_OF_STREAM && std::string_view("0123456789+-.eE").find(static_cast<char>(c)) != std::string_view::npos; c = sb.snextc()) {
+                token += static_cast<char>(c);
+            }
+            try {
+                value = nlohmann::json::parse(token);
+                return true;
+            }
+            catch (const nlohmann::json::parse_error& e) {
+                error = e.what();
+                return false;
+            }
+        }
+
+        // SAX handler that builds only the values found at a JSON path. 'frames' mirrors the
+        // containers open in the input and records whether each one is still on the path,
+        // so every value is placed in constant time and values off the path are never built.
+        class JsonSelector : public nlohmann::json_sax<nlohmann::json> {
+        public:
+            JsonSelector(const std::vector<JsonPathStep>& path, std::vector<nlohmann::json>& matches)
+                : path(path), matches(matches) {}
+
+            bool null() override { return add(nullptr); }
+            bool boolean(bool val) override { return add(val); }
+            bool number_integer(number_integer_t val) override { return add(val); }
+            bool number_unsigned(number_unsigned_t val) override { return add(val); }
+            bool number_float(number_float_t val, const string_t&) override { return add(val); }
+            bool string(string_t& val) override { return add(std::move(val)); }
+            bool binary(binary_t&) override { return add(nullptr); } // Not produced by JSON text
+
+            bool start_object(std::size_t) override { return open(nlohmann::json::object(), false); }
+            bool start_array(std::size_t) override { return open(nlohmann::json::array(), true); }
+            bool end_object() override { return close(); }
+            bool end_array() override { return close(); }
+
+            bool key(string_t& val) override {
+                if (!building.empty()) pending_key = std::move(val);
+                else frames.back().key = std::move(val);
+                return true;
+            }
+
+            bool parse_error(std::size_t, const std::string&, const nlohmann::detail::exception& ex) override {
+                error = ex.what();
+                return false;
+            }
+
+            std::string error;
+
+        private:
+            struct Frame {
+                bool is_array = false;
+                bool on_path = false; // This container's path matches the first steps of 'path'
+                size_t next_index = 0;
+                std::string key;      // Key of the current member (objects)
+            };
+
+            enum class Place { Off, OnPath, Match };
+
+            // Locates the value that starts now relative to the path.
+            Place place_next() {
+                const size_t depth = frames.size();
+                if (depth > 0) {
+                    Frame& parent = frames.back();
+                    const size_t index = parent.is_array ? parent.next_index++ : 0;
+                    if (!parent.on_path || depth > path.size()) return Place::Off;
+
+                    const JsonPathStep& step = path[depth - 1];
+                    const bool step_matches =
+                        step.kind == JsonPathStep::Kind::Any ||
+                        (step.kind == JsonPathStep::Kind::Key && !parent.is_array && parent.key == step.key) ||
+                        (step.kind == JsonPathStep::Kind::Index && parent.is_array && index == step.index);
+                    if (!step_matches) return Place::Off;
+                }
+                return depth == path.size() ? Place::Match : Place::OnPath;
+            }
+
+            // Adds a value to the match being built.
+            nlohmann::json* insert(nlohmann::json&& value) {
+                nlohmann::json& parent = *building.back();
+                if (parent.is_array()) {
+                    parent.push_back(std::move(value));
+                    return &parent.back();
+                }
+                nlohmann::json& member = parent[pending_key];
+                member = std::move(value);
+                return &member;
+            }
+
+            template <typename T>
+            bool add(T&& val) {
+                if (!building.empty()) insert(nlohmann::json(std::forward<T>(val)));
+                else if (place_next() == Place::Match) matches.emplace_back(std::forward<T>(val));
+                return true;
+            }
+
+            bool open(nlohmann::json&& container, bool is_array) {
+                if (!building.empty()) {
+                    building.push_back(insert(std::move(container)));
+                    return true;
+                }
+                const Place place = place_next();
+                if (place == Place::Match) {
+                    matches.push_back(std::move(container));
+                    building.push_back(&matches.back());
+                }
+                else {
+                    frames.push_back(Frame{ is_array, place == Place::OnPath, 0, {} });
+                }
+                return true;
+            }
+
+            bool close() {
+                if (!building.empty()) building.pop_back();
+                else frames.pop_back();
+                return true;
+            }
+
+            const std::vector<JsonPathStep>& path;
+            std::vector<nlohmann::json>& matches;
+            std::vector<Frame> frames;
+            std::vector<nlohmann::json*> building; // Containers of the match under construction
+            std::string pending_key;
+        };
+    }
+
+    bool parse_json_path(std::string_view path, std::vector<JsonPathStep>& steps, std::string& error) {
+        steps.clear();
+        size_t i = 0;
+        if (i < path.size() && path[i] == '$') ++i;
+
+        while (i < path.size()) {
+            JsonPathStep step;
+            if (path[i] == '.') {
+                ++i;
+                if (i < path.size() && path[i] == '*') {
+                    ++i;
+                }
+                else {
+                    const size_t end = std::min(path.find_first_of(".[", i), path.size());
+                    if (end == i) { error = "Missing member name after '.' in JSON path."; return false; }
+                    step.kind = JsonPathStep::Kind::Key;
+                    step.key = std::string(path.substr(i, end - i));
+                    i = end;
+                }
+            }
+            else if (path[i] == '[') {
+                ++i;
+                if (i < path.size() && (path[i] == '\'' || path[i] == '"')) {
+                    const char quote = path[i++];
+                    const size_t end = path.find(quote, i);
+                    if (end == std::string_view::npos) { error = "Unterminated key in JSON path."; return false; }
+                    step.kind = JsonPathStep::Kind::Key;
+                    step.key = std::string(path.substr(i, end - i));
+                    i = end + 1;
+                }
+                else if (i < path.size() && path[i] == '*') {
+                    ++i;
+                }
+                else {
+                    auto [ptr, ec] = std::from_chars(path.data() + i, path.data() + path.size(), step.index);
+                    if (ec != std::errc()) { error = "Invalid index in JSON path."; return false; }
+                    step.kind = JsonPathStep::Kind::Index;
+                    i = static_cast<size_t>(ptr - path.data());
+                }
+                if (i >= path.size() || path[i] != ']') { error = "Missing ']' in JSON path."; return false; }
+                ++i;
+            }
+            else {
+                error = "Unexpected '" + std::string(1, path[i]) + "' in JSON path.";
+                return false;
+            }
+            steps.push_back(std::move(step));
+        }
+        return true;
+    }
+
+    bool select_json(std::istream& in, const std::vector<JsonPathStep>& path, std::vector<nlohmann::json>& matches, std::string& error) {
+        JsonSelector selector(path, matches);
+        while (skip_json_space(*in.rdbuf()) != END_OF_STREAM) {
+            if (!nlohmann::json::sax_parse(in, &selector, nlohmann::json::input_format_t::json, false)) {
+                error = selector.error;
+                return false;
+            }
+        }
+        return true;
+    }
+
+    // --- JsonReader ---
+
+    JsonReader::~JsonReader() {
+        close();
+    }
+
+    bool JsonReader::open(const std::string& filename) {
+        close();
+        if (!file.open(filename)) return false;
+        view.attach(file.text());
+
+        // Skip a UTF-8 byte order mark, then see whether the records are wrapped in an array.
+        std::streambuf& sb = *in.rdbuf();
+        if (sb.sgetc() == 0xEF) {
+            sb.sbumpc();
+            if (sb.sbumpc() != 0xBB || sb.sbumpc() != 0xBF) return false;
+        }
+        if (peek() == '[') {
+            sb.sbumpc();
+            array_mode = true;
+            if (peek() == ']') finished = true;
+        }
+        return true;
+    }
+
+    void JsonReader::close() {
+        view.attach({});
+        file.close();
+        in.clear();
+        array_mode = false;
+        finished = false;
+    }
+
+    int JsonReader::peek() {
+        return skip_json_space(*in.rdbuf());
+    }
+
+    bool JsonReader::at_end() {
+        if (!finished && (!file.is_open() || peek() == END_OF_STREAM)) finished = true;
+        return finished;
+    }
+
+    bool JsonReader::next(nlohmann::json& record, std::string& error) {
+        if (at_end()) return false;
+
+        std::streambuf& sb = *in.rdbuf();
+        const int c = peek();
+        if (c == '-' || (c >= '0' && c <= '9')) {
+            if (!read_json_number(sb, record, error)) {
+                finished = true;
+                return false;
+            }
+        }
+        else {
+            static const std::vector<JsonPathStep> whole_value;
+            std::vector<nlohmann::json> values;
+            JsonSelector selector(whole_value, values);
+            if (!nlohmann::json::sax_parse(in, &selector, nlohmann::json::input_format_t::json, false) || values.empty()) {
+                error = selector.error;
+                finished = true;
+                return false;
+            }
+            record = std::move(values.front());
+        }
+
+        if (array_mode) {
+            // Consume the separator, so at_end() is true right after the last element.
+            const int sep = peek();
+            if (sep == ',') {
+                sb.sbumpc();
+            }
+            else if (sep == ']' || sep == END_OF_STREAM) {
+                sb.sbumpc();
+                finished = true;
+            }
+            else {
+                error = "Expected ',' or ']' after an array element.";
+                finished = true;
+                return false;
+            }
+        }
+        return true;
+    }
+}
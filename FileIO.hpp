@@ -0,0 +1,194 @@
+// FileIO.hpp
+#pragma once
+#include <string>
+#include <string_view>
+#include <vector>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <istream>
+#include <streambuf>
+#include "Types.hpp"
+
+// A namespace for the low-level file readers behind the file I/O builtins.
+namespace FileIO {
+
+    // Read-only view of an entire file. The file is memory-mapped, so opening is cheap
+    // and pages are only read from disk when they are touched.
+    class MappedFile {
+    public:
+        MappedFile() = default;
+        ~MappedFile();
+        MappedFile(const MappedFile&) = delete;
+        MappedFile& operator=(const MappedFile&) = delete;
+
+        // Maps the file. Returns false if it cannot be opened.
+        bool open(const std::string& filename);
+        void close();
+
+        bool is_open() const { return opened; }
+        const char* data() const { return view; }
+        size_t size() const { return length; }
+        std::string_view text() const { return std::string_view(view ? view : "", length); }
+
+    private:
+        bool opened = false;
+        const char* view = nullptr;
+        size_t length = 0;
+#ifdef _WIN32
+        void* file_handle = nullptr;
+        void* mapping_handle = nullptr;
+#else
+        int fd = -1;
+#endif
+    };
+
+    // Buffered text file behind a FILE.OPEN handle. Reads line by line through a large
+    // internal buffer, so a file is never loaded as a whole; writes are block-buffered.
+    class TextFile {
+    public:
+        enum class Mode { Read, Write, Append };
+
+        TextFile() = default;
+        ~TextFile();
+        TextFile(const TextFile&) = delete;
+        TextFile& operator=(const TextFile&) = delete;
+
+        bool open(const std::string& filename, Mode mode);
+        void close();
+
+        Mode mode() const { return open_mode; }
+
+        // Reads the next line without its line terminator. Returns false at the end of the file.
+        bool read_line(std::string& line);
+        bool eof();
+
+        // Writes text as-is. Returns false on an I/O error.
+        bool write(std::string_view text);
+
+    private:
+        // Refills the read buffer. Returns false if nothing more could be read.
+        bool fill();
+
+        std::FILE* fp = nullptr;
+        Mode open_mode = Mode::Read;
+        std::vector<char> buffer;
+        size_t buf_pos = 0;
+        size_t buf_len = 0;
+    };
+
+    // --- Delimited text (CSV) helpers ---
+
+    // Returns the offset of the '\n' that ends the record starting at pos, or text.size().
+    // Line breaks inside "quoted fields" do not end a record.
+    size_t find_record_end(std::string_view text, size_t pos);
+
+    // Splits one record into raw fields. Quoted fields keep their quotes.
+    // Stops after max_fields fields, leaving the rest of the record unscanned.
+    void split_record(std::string_view record, char delimiter, std::vector<std::string_view>& fields, size_t max_fields = SIZE_MAX);
+
+    // Removes surrounding quotes from a raw field and collapses "" escapes.
+    std::string unquote_field(std::string_view field);
+
+    // Parses a numeric field (surrounding blanks and quotes are ignored).
+    // Returns false if the field does not start with a number, or with whole_field set,
+    // if anything follows the number.
+    bool parse_double(std::string_view field, double& out, bool whole_field = false);
+
+    // Reads records from a memory-mapped delimited file.
+    class CsvReader {
+    public:
+        // Opens the file and, if has_header is set, consumes the header record.
+        bool open(const std::string& filename, char delimiter, bool has_header);
+        void close();
+
+        bool at_end() const { return pos >= file.size(); }
+        const std::vector<std::string>& header() const { return header_names; }
+
+        // Restricts reading to the given 0-based columns, in that order. Cells after the
+        // last selected column are never scanned and unselected cells are never parsed.
+        void select_columns(std::vector<size_t> columns);
+
+        // Splits the next non-empty record into raw fields (views into the mapped file,
+        // valid until the reader is closed). Returns false at the end of the file.
+        bool next_fields(std::vector<std::string_view>& fields);
+
+        // Parses up to max_rows records (0 = all remaining) as numbers and appends them
+        // row-major to 'out'. Non-numeric cells become 0.0. Large batches are parsed in
+        // parallel. Returns false if a record has a different field count than the first.
+        bool read_numeric(size_t max_rows, std::vector<BasicValue>& out, size_t& rows, size_t& cols);
+
+    private:
+        // Collects the [begin, end) spans of up to max_rows non-empty records.
+        void index_records(size_t max_rows, std::vector<std::pair<size_t, size_t>>& records);
+
+        // Moves past empty records, so at_end() is true as soon as no record is left.
+        void skip_empty_records();
+
+        MappedFile file;
+        char delimiter = ',';
+        size_t pos = 0;
+        size_t column_count = 0; // Field count of the first data record (0 = not known yet)
+        std::vector<size_t> selected_columns;
+        std::vector<std::string> header_names;
+    };
+
+    // --- Streaming JSON ---
+
+    // Reads a memory-mapped file through the std::istream interface of the JSON parser.
+    // The stream reads straight from the mapped pages, so no read buffer is needed.
+    class MappedStreamBuf : public std::streambuf {
+    public:
+        void attach(std::string_view text) {
+            char* begin = const_cast<char*>(text.data()); // The get area is never written
+            setg(begin, begin, begin + text.size());
+        }
+    };
+
+    // One step of a JSON path: .key / ['key'], [n], or the wildcards [*] / .*
+    struct JsonPathStep {
+        enum class Kind { Key, Index, Any } kind = Kind::Any;
+        std::string key;
+        size_t index = 0;
+    };
+
+    // Parses a JSON path such as "$.items[*].id" or "$['a b'][0]". The leading '$' is optional.
+    // Returns false and sets 'error' if the path is malformed.
+    bool parse_json_path(std::string_view path, std::vector<JsonPathStep>& steps, std::string& error);
+
+    // Runs the JSON parser over every top-level value of a stream (one document, or one
+    // value per line for NDJSON) and appends the values found at 'path' to 'matches'. Values
+    // outside the path are scanned but never built, so memory use is bounded by the matches.
+    // Returns false and sets 'error' on malformed JSON.
+    bool select_json(std::istream& in, const std::vector<JsonPathStep>& path, std::vector<nlohmann::json>& matches, std::string& error);
+
+    // Reads a large JSON file one record at a time: the elements of a top-level array, or
+    // the values of an NDJSON file. The file is memory-mapped and only the current record
+    // is ever parsed into memory.
+    class JsonReader {
+    public:
+        JsonReader() = default;
+        ~JsonReader();
+        JsonReader(const JsonReader&) = delete;
+        JsonReader& operator=(const JsonReader&) = delete;
+
+        bool open(const std::string& filename);
+        void close();
+
+        bool at_end();
+
+        // Parses the next record. Returns false at the end of the file, or with 'error'
+        // set if the record is malformed.
+        bool next(nlohmann::json& record, std::string& error);
+
+    private:
+        // Skips whitespace and returns the next character without consuming it (EOF at the end).
+        int peek();
+
+        MappedFile file;
+        MappedStreamBuf view;
+        std::istream in{ &view };
+        bool array_mode = false;  // Records are the elements of a top-level array
+        bool finished = false;
+    };
+}
@@ -1,12 +1,55 @@
 #include "LocaleManager.hpp"
 #include "Error.hpp"
 #include "TextIO.hpp"
+#include "StringUtils.hpp"
 #include <iostream>
+#include <charconv>
+#include <climits>
+#include <algorithm>
 
 namespace {
     // This static variable holds the current locale for the entire application.
     // It's initialized to the default "C" locale.
     std::locale g_current_locale("C");
+
+    LocaleManager::NumberPunct read_number_punct(const std::locale& loc) {
+        const auto& facet = std::use_facet<std::numpunct<char>>(loc);
+        LocaleManager::NumberPunct punct;
+        punct.decimal_point = facet.decimal_point();
+        punct.thousands_sep = facet.thousands_sep();
+        punct.grouping = facet.grouping();
+        return punct;
+    }
+
+    LocaleManager::NumberPunct g_number_punct = read_number_punct(g_current_locale);
+
+    // Inserts thousands separators into the integer digits that start at 'first'.
+    void group_digits(std::string& out, size_t first, const LocaleManager::NumberPunct& punct) {
+        size_t last = first;
+        while (last < out.size() && out[last] >= '0' && out[last] <= '9') ++last;
+
+        // Walk the group sizes from the right; the last size repeats.
+        std::string grouped;
+        size_t group_index = 0;
+        size_t in_group = 0;
+        for (size_t i = last; i > first; --i) {
+            const char size = punct.grouping[group_index];
+            if (size <= 0 || size == CHAR_MAX) {
+                grouped.append(out.rend() - i, out.rend() - first);
+                break;
+            }
+            if (in_group == static_cast<size_t>(size)) {
+                grouped += punct.thousands_sep;
+                in_group = 0;
+                if (group_index + 1 < punct.grouping.size()) ++group_index;
+            }
+            grouped += out[i - 1];
+            ++in_group;
+        }
+        if (grouped.size() == last - first) return;
+        std::reverse(grouped.begin(), grouped.end());
+        out.replace(first, last - first, grouped);
+    }
 }
 
 namespace LocaleManager {
@@ -14,8 +57,9 @@ namespace LocaleManager {
     void set_current_locale(const std::string& locale_name) {
         try {
             g_current_locale = std::locale(locale_name.c_str());
+            g_number_punct = read_number_punct(g_current_locale);
             // Also imbue the standard cout for any direct C++ printing
-            std::cout.imbue(g_current_locale);
+            TextIO::imbue(g_current_locale);
         }
         catch (const std::runtime_error&) {
             Error::set(1, 0); // Re-use "Syntax Error" or create a new "Invalid Locale" error
@@ -26,4 +70,26 @@ namespace LocaleManager {
     const std::locale& get_current_locale() {
         return g_current_locale;
     }
-}
\ No newline at end of file
+
+    const NumberPunct& get_number_punct() {
+        return g_number_punct;
+    }
+
+    void append_number(std::string& out, double value, int precision) {
+        const size_t start = out.size();
+        StringUtils::append_number(out, value, precision, g_number_punct.decimal_point);
+        if (!g_number_punct.grouping.empty()) {
+            group_digits(out, (start < out.size() && out[start] == '-') ? start + 1 : start, g_number_punct);
+        }
+    }
+
+    void append_number(std::string& out, long long value) {
+        char buf[24];
+        auto res = std::to_chars(buf, buf + sizeof(buf), value);
+        const size_t start = out.size();
+        out.append(buf, res.ptr);
+        if (!g_number_punct.grouping.empty()) {
+            group_digits(out, value < 0 ? start + 1 : start, g_number_punct);
+        }
+    }
+}
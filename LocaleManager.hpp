@@ -3,9 +3,25 @@
 #include <locale>
 
 namespace LocaleManager {
+    // Number punctuation of the current locale. It is looked up once when the locale
+    // is set, so formatting a number never has to query the numpunct facet.
+    struct NumberPunct {
+        char decimal_point = '.';
+        char thousands_sep = ',';
+        std::string grouping; // Digit group sizes as in std::numpunct (empty = no grouping)
+    };
+
     // Sets the global locale for number formatting.
     void set_current_locale(const std::string& locale_name);
 
     // Gets the currently active locale.
     const std::locale& get_current_locale();
+
+    // Gets the cached number punctuation of the active locale.
+    const NumberPunct& get_number_punct();
+
+    // Appends a number the way PRINT shows it: at most 'precision' decimals, trailing zeros
+    // removed, using the locale's decimal point and digit grouping.
+    void append_number(std::string& out, double value, int precision = 6);
+    void append_number(std::string& out, long long value);
 }
@@ -17,6 +17,7 @@
 #include <conio.h>
 #include <algorithm> // for std::transform, std::find_if
 #include <cctype>    // for std::isspace, std::toupper
+#include <cmath>     // for std::pow
 
 const std::string NERELA_VERSION = "0.7.2";
 
@@ -54,47 +55,52 @@ void trim(std::string& s) {
 }
 
 // --- MODIFIED: The chain resolver now handles both UDTs (Maps) and COM Objects ---
+// The chain is walked segment by segment as string_views, and UDT members are followed
+// by pointer, so no intermediate object is copied on the way to the last member.
 std::pair<BasicValue, std::string> NeReLaBasic::resolve_dot_chain(const std::string& chain_string) {
-    std::stringstream ss(chain_string);
-    std::string segment;
-    std::vector<std::string> parts;
-    while (std::getline(ss, segment, '.')) {
-        parts.push_back(segment);
-    }
-
-    if (parts.empty()) {
+    if (chain_string.empty()) {
         Error::set(1, runtime_current_line);
         return {};
     }
+    const std::string_view chain = chain_string;
+    size_t dot = chain.find('.');
 
     // Get the base variable (e.g., "PLAYER").
-    BasicValue current_object = get_variable(*this, to_upper(parts[0]));
+    const BasicValue* current_object = &get_variable(*this, to_upper(std::string(chain.substr(0, dot))));
+    if (dot == std::string_view::npos) {
+        return { *current_object, "" };
+    }
+    BasicValue com_result; // Holds objects returned by COM calls, which have no other owner
 
     // Navigate the chain up to the second-to-last part.
-    for (size_t i = 1; i < parts.size() - 1; ++i) {
-        std::string& part = parts[i];
+    size_t last_dot = chain.rfind('.');
+    while (dot != last_dot) {
+        const size_t next_dot = chain.find('.', dot + 1);
+        const std::string_view part = chain.substr(dot + 1, next_dot - dot - 1);
+        dot = next_dot;
 
         // Check if we have a UDT (Map) or a COM object
-        if (std::holds_alternative<std::shared_ptr<Map>>(current_object)) {
-            auto& map_ptr = std::get<std::shared_ptr<Map>>(current_object);
-            if (map_ptr && map_ptr->data.count(part)) {
-                current_object = map_ptr->data.at(part);
-            }
-            else {
-                Error::set(3, runtime_current_line, "Member not found: " + part); return {};
+        if (std::holds_alternative<std::shared_ptr<Map>>(*current_object)) {
+            const auto& map_ptr = std::get<std::shared_ptr<Map>>(*current_object);
+            const BasicValue* member = map_ptr ? map_ptr->data.find_value(part) : nullptr;
+            if (!member) {
+                Error::set(3, runtime_current_line, "Member not found: " + std::string(part)); return {};
             }
+            current_object = member;
         }
 #ifdef JDCOM
-        else if (std::holds_alternative<ComObject>(current_object)) {
-            IDispatchPtr pDisp = std::get<ComObject>(current_object).ptr;
+        else if (std::holds_alternative<ComObject>(*current_object)) {
+            IDispatchPtr pDisp = std::get<ComObject>(*current_object).ptr;
             if (!pDisp) { Error::set(1, runtime_current_line, "Uninitialized COM object."); return {}; }
+            const std::string member_name(part);
             _variant_t result_vt;
-            HRESULT hr = invoke_com_method(pDisp, part, {}, result_vt, DISPATCH_PROPERTYGET);
+            HRESULT hr = invoke_com_method(pDisp, member_name, {}, result_vt, DISPATCH_PROPERTYGET);
             if (FAILED(hr)) {
-                hr = invoke_com_method(pDisp, part, {}, result_vt, DISPATCH_METHOD);
-                if (FAILED(hr)) { Error::set(12, runtime_current_line, "COM member not found: " + part); return {}; }
+                hr = invoke_com_method(pDisp, member_name, {}, result_vt, DISPATCH_METHOD);
+                if (FAILED(hr)) { Error::set(12, runtime_current_line, "COM member not found: " + member_name); return {}; }
             }
-            current_object = variant_t_to_basic_value(result_vt, *this);
+            com_result = variant_t_to_basic_value(result_vt, *this);
+            current_object = &com_result;
         }
 #endif
         else {
@@ -103,12 +109,7 @@ std::pair<BasicValue, std::string> NeReLaBasic::resolve_dot_chain(const std::str
         }
     }
 
-    if (parts.size() > 1) {
-        return { current_object, parts.back() };
-    }
-    else {
-        return { current_object, "" };
-    }
+    return { *current_object, std::string(chain.substr(last_dot + 1)) };
 }
 
 // Constructor: Initializes the interpreter state
@@ -179,6 +180,7 @@ void NeReLaBasic::start() {
         direct_p_code.clear();
         linenr = 0;
         TextIO::print("Ready\n? ");
+        TextIO::flush();
 
         if (!std::getline(std::cin, inputLine) || inputLine.empty()) {
             std::cin.clear();
@@ -194,6 +196,7 @@ void NeReLaBasic::start() {
                 is_stopped = false;
                 execute(program_p_code, true); // Continues from the saved pcode
                 if (Error::get() != 0) Error::print();
+                if (!is_stopped) close_program_resources();
             }
             else {
                 TextIO::print("?Nothing to resume.\n");
@@ -1229,6 +1232,7 @@ void NeReLaBasic::execute_repl_command(const std::vector<uint8_t>& repl_p_code)
 
 // In NeReLaBasic.cpp
 void NeReLaBasic::pause_for_debugger() {
+    TextIO::flush(); // Show all output up to the stop before waiting for the client
     std::unique_lock<std::mutex> lock(dap_mutex);
     dap_command_received = false;
     dap_cv.wait(lock, [this] { return dap_command_received; });
@@ -1254,6 +1258,17 @@ void NeReLaBasic::step_over() {
     dap_cv.notify_one();
 }
 
+void NeReLaBasic::close_program_resources() {
+    file_handles.clear(); // Flushes and closes the files
+    next_file_handle = 1;
+    csv_cursors.clear();
+    next_csv_cursor = 1;
+    json_readers.clear();
+    next_json_reader = 1;
+    string_builders.clear();
+    next_string_builder = 1;
+}
+
 void NeReLaBasic::execute(const std::vector<uint8_t>& code_to_run, bool resume_mode) {
     // If there's no code to run, do nothing.
     if (code_to_run.empty()) {
@@ -1303,6 +1318,7 @@ void NeReLaBasic::execute(const std::vector<uint8_t>& code_to_run, bool resume_m
                 // Let's use the spacebar to pause
                 else if (key == ' ') {
                     TextIO::print("\n--- PAUSED (Press any key to resume) ---\n");
+                    TextIO::flush();
                     _getch(); // Wait for another key press to un-pause
                     TextIO::print("--- RESUMED ---\n");
                 }
@@ -1311,6 +1327,7 @@ void NeReLaBasic::execute(const std::vector<uint8_t>& code_to_run, bool resume_m
         // --- >> DAP INTEGRATION POINT << ---
         if (debug_state == DebugState::PAUSED) {
             // We are paused, waiting for the DAP client
+            TextIO::flush();
             std::unique_lock<std::mutex> lock(dap_mutex);
             dap_cv.wait(lock, [this] { return dap_command_received; });
             dap_command_received = false; // Reset the flag
@@ -1471,6 +1488,8 @@ void NeReLaBasic::execute(const std::vector<uint8_t>& code_to_run, bool resume_m
     active_p_code = prev_active_p_code;
     // Clear the global VM pointer when execution finishes
     g_vm_instance_ptr = nullptr;
+    // Write out buffered program output
+    TextIO::flush();
 }
 
 void NeReLaBasic::statement() {
@@ -1724,8 +1743,9 @@ BasicValue NeReLaBasic::parse_primary() {
             if (final_member.empty()) { current_value = final_obj; }
             else if (std::holds_alternative<std::shared_ptr<Map>>(final_obj)) {
                 auto& map_ptr = std::get<std::shared_ptr<Map>>(final_obj);
-                if (map_ptr && map_ptr->data.count(final_member)) {
-                    current_value = map_ptr->data.at(final_member);
+                const BasicValue* member = map_ptr ? map_ptr->data.find_value(final_member) : nullptr;
+                if (member) {
+                    current_value = *member;
                 }
                 else { Error::set(3, runtime_current_line, "Member not found: " + final_member); return {}; }
             }
@@ -1836,6 +1856,12 @@ BasicValue NeReLaBasic::parse_primary() {
     else { Error::set(1, runtime_current_line); return {}; }
     if (Error::get() != 0) return {};
 
+    // While the chain walks through a JsonObject, the current element is only tracked as a
+    // pointer into the document (kept alive by json_doc). It is converted to a BasicValue
+    // when the chain ends, so the objects and arrays passed on the way are never copied.
+    std::shared_ptr<JsonObject> json_doc;
+    const nlohmann::json* json_node = nullptr;
+
     // --- MAIN LOOP FOR HANDLING ACCESSORS LIKE [..], {..}, .member ---
     while (true) {
         Tokens::ID accessor_token = static_cast<Tokens::ID>((*active_p_code)[pcode]);
@@ -1884,14 +1910,17 @@ BasicValue NeReLaBasic::parse_primary() {
                     return {};
                 }
             }
-            else if (std::holds_alternative<std::shared_ptr<JsonObject>>(current_value)) {
+            else if (json_node || std::holds_alternative<std::shared_ptr<JsonObject>>(current_value)) {
                 if (indices.size() != 1) {
                     Error::set(15, runtime_current_line, "Multi-dimensional indexing is not supported for JSON objects."); return {};
                 }
                 size_t index = indices[0];
-                const auto& json_ptr = std::get<std::shared_ptr<JsonObject>>(current_value);
-                if (!json_ptr || !json_ptr->data.is_array() || index >= json_ptr->data.size()) { Error::set(10, runtime_current_line, "JSON index out of bounds."); return {}; }
-                current_value = json_to_basic_value(json_ptr->data[index]);
+                if (!json_node) {
+                    json_doc = std::get<std::shared_ptr<JsonObject>>(current_value);
+                    if (json_doc) json_node = &json_doc->data;
+                }
+                if (!json_node || !json_node->is_array() || index >= json_node->size()) { Error::set(10, runtime_current_line, "JSON index out of bounds."); return {}; }
+                json_node = &(*json_node)[index];
             }
             else { Error::set(15, runtime_current_line, "Indexing '[]' can only be used on an Array."); return {}; }
 
@@ -1900,24 +1929,39 @@ BasicValue NeReLaBasic::parse_primary() {
             pcode++; // Consume '{'
             BasicValue key_val = evaluate_expression();
             if (Error::get() != 0) return {};
-            std::string key = to_string(key_val);
+            std::string key_buffer;
+            std::string_view key = to_key_view(key_val, key_buffer);
             if (static_cast<Tokens::ID>((*active_p_code)[pcode++]) != Tokens::ID::C_RIGHTBRACE) { Error::set(17, runtime_current_line, "Missing '}' in map access."); return {}; }
 
             if (std::holds_alternative<std::shared_ptr<Map>>(current_value)) {
                 const auto& map_ptr = std::get<std::shared_ptr<Map>>(current_value);
-                if (!map_ptr || map_ptr->data.find(key) == map_ptr->data.end()) { Error::set(3, runtime_current_line, "Map key not found: " + key); return {}; }
-                BasicValue next_val = map_ptr->data.at(key);
+                const BasicValue* entry = map_ptr ? map_ptr->data.find_value(key) : nullptr;
+                if (!entry) { Error::set(3, runtime_current_line, "Map key not found: " + std::string(key)); return {}; }
+                BasicValue next_val = *entry; // Copy before current_value (which may own the map) is replaced
                 current_value = std::move(next_val);
             }
-            else if (std::holds_alternative<std::shared_ptr<JsonObject>>(current_value)) {
-                const auto& json_ptr = std::get<std::shared_ptr<JsonObject>>(current_value);
-                if (!json_ptr || !json_ptr->data.is_object() || !json_ptr->data.contains(key)) { Error::set(3, runtime_current_line, "JSON key not found: " + key); return {}; }
-                current_value = json_to_basic_value(json_ptr->data.at(key));
+            else if (json_node || std::holds_alternative<std::shared_ptr<JsonObject>>(current_value)) {
+                if (!json_node) {
+                    json_doc = std::get<std::shared_ptr<JsonObject>>(current_value);
+                    if (json_doc) json_node = &json_doc->data;
+                }
+                const nlohmann::json* child = nullptr;
+                if (json_node && json_node->is_object()) {
+                    auto it = json_node->find(key);
+                    if (it != json_node->end()) child = &*it;
+                }
+                if (!child) { Error::set(3, runtime_current_line, "JSON key not found: " + std::string(key)); return {}; }
+                json_node = child;
             }
             else { Error::set(15, runtime_current_line, "Key access '{}' can only be used on a Map or JSON object."); return {}; }
 
         }
         else if (accessor_token == Tokens::ID::C_DOT) {
+            if (json_node) {
+                current_value = json_to_basic_value(*json_node);
+                json_node = nullptr;
+                json_doc.reset();
+            }
             pcode++; // Consume '.'
             Tokens::ID member_token = static_cast<Tokens::ID>((*active_p_code)[pcode]);
             if (member_token != Tokens::ID::VARIANT && member_token != Tokens::ID::INT && member_token != Tokens::ID::STRVAR) {
@@ -1928,8 +1972,10 @@ BasicValue NeReLaBasic::parse_primary() {
 
             if (std::holds_alternative<std::shared_ptr<Map>>(current_value)) {
                 const auto& map_ptr = std::get<std::shared_ptr<Map>>(current_value);
-                if (!map_ptr || map_ptr->data.find(member_name) == map_ptr->data.end()) { Error::set(3, runtime_current_line, "Member '" + member_name + "' not found in object."); return {}; }
-                current_value = map_ptr->data.at(member_name);
+                const BasicValue* member = map_ptr ? map_ptr->data.find_value(member_name) : nullptr;
+                if (!member) { Error::set(3, runtime_current_line, "Member '" + member_name + "' not found in object."); return {}; }
+                BasicValue next_val = *member;
+                current_value = std::move(next_val);
             }
 #ifdef JDCOM
             else if (std::holds_alternative<ComObject>(current_value)) {
@@ -1946,6 +1992,7 @@ BasicValue NeReLaBasic::parse_primary() {
             break; // No more accessors, break the loop
         }
     }
+    if (json_node) return json_to_basic_value(*json_node);
     return current_value;
 }
 
@@ -1969,6 +2016,104 @@ BasicValue NeReLaBasic::parse_unary() {
     return parse_primary();
 }
 
+// --- Element-wise array kernels ---
+// Array operators are evaluated eagerly, but in a chain like (A - M) * (A - M) / N every
+// intermediate result is an unshared temporary. Instead of allocating a fresh Array for
+// each operator, the kernels below write into such a temporary in place, so a chain only
+// needs one buffer per independent sub-expression. The operator is resolved once, outside
+// the element loop.
+namespace {
+    // Picks the destination for an element-wise result. An operand held by nobody else
+    // (use_count == 1) is a temporary of the current expression and can be overwritten.
+    std::shared_ptr<Array> elementwise_target(const std::shared_ptr<Array>& a, const std::shared_ptr<Array>& b = nullptr) {
+        if (a.use_count() == 1) return a;
+        if (b && b.use_count() == 1) return b;
+        auto result_ptr = std::make_shared<Array>();
+        result_ptr->shape = a->shape;
+        result_ptr->data.resize(a->data.size());
+        return result_ptr;
+    }
+
+    template <typename F>
+    void fuse_array_array(Array& dst, const Array& a, const Array& b, F f) {
+        const size_t n = a.data.size();
+        for (size_t i = 0; i < n; ++i) dst.data[i] = f(to_double(a.data[i]), to_double(b.data[i]));
+    }
+
+    template <typename F>
+    void fuse_array_scalar(Array& dst, const Array& a, double scalar, F f) {
+        const size_t n = a.data.size();
+        for (size_t i = 0; i < n; ++i) dst.data[i] = f(to_double(a.data[i]), scalar);
+    }
+
+    template <typename F>
+    void fuse_scalar_array(Array& dst, double scalar, const Array& b, F f) {
+        const size_t n = b.data.size();
+        for (size_t i = 0; i < n; ++i) dst.data[i] = f(scalar, to_double(b.data[i]));
+    }
+
+    // Dispatches an arithmetic operator to one of the fused loops above. 'apply' receives
+    // the per-element lambda; 'div_zero' is raised instead of aborting mid-loop.
+    template <typename Apply>
+    bool dispatch_arithmetic(Tokens::ID op, bool& div_zero, Apply apply) {
+        switch (op) {
+        case Tokens::ID::C_PLUS:  apply([](double x, double y) { return x + y; }); return true;
+        case Tokens::ID::C_MINUS: apply([](double x, double y) { return x - y; }); return true;
+        case Tokens::ID::C_ASTR:  apply([](double x, double y) { return x * y; }); return true;
+        case Tokens::ID::C_CARET: apply([](double x, double y) { return std::pow(x, y); }); return true;
+        case Tokens::ID::C_SLASH:
+            apply([&div_zero](double x, double y) {
+                if (y == 0.0) { div_zero = true; return 0.0; }
+                return x / y;
+                });
+            return true;
+        case Tokens::ID::MOD:
+            apply([&div_zero](double x, double y) {
+                long long lx = static_cast<long long>(x);
+                long long ly = static_cast<long long>(y);
+                if (ly == 0) { div_zero = true; return 0.0; }
+                return static_cast<double>(lx % ly);
+                });
+            return true;
+        default:
+            return false;
+        }
+    }
+}
+
+// Applies an arithmetic operator where at least one side is an array.
+// Shared by parse_term and parse_factor.
+BasicValue NeReLaBasic::apply_array_arithmetic(Tokens::ID op, const BasicValue& left, const BasicValue& right) {
+    const auto* l = std::get_if<std::shared_ptr<Array>>(&left);
+    const auto* r = std::get_if<std::shared_ptr<Array>>(&right);
+    if ((l && !*l) || (r && !*r)) { Error::set(15, runtime_current_line); return false; } // Null array error
+
+    std::shared_ptr<Array> result_ptr;
+    bool div_zero = false;
+
+    // Case 1: Array-Array operation
+    if (l && r) {
+        if ((*l)->shape != (*r)->shape) { Error::set(15, runtime_current_line); return false; } // Shape mismatch
+        result_ptr = elementwise_target(*l, *r);
+        dispatch_arithmetic(op, div_zero, [&](auto f) { fuse_array_array(*result_ptr, **l, **r, f); });
+    }
+    // Case 2: Array-Scalar operation
+    else if (l) {
+        double scalar = to_double(right);
+        result_ptr = elementwise_target(*l);
+        dispatch_arithmetic(op, div_zero, [&](auto f) { fuse_array_scalar(*result_ptr, **l, scalar, f); });
+    }
+    // Case 3: Scalar-Array operation
+    else {
+        double scalar = to_double(left);
+        result_ptr = elementwise_target(*r);
+        dispatch_arithmetic(op, div_zero, [&](auto f) { fuse_scalar_array(*result_ptr, scalar, **r, f); });
+    }
+
+    if (div_zero) { Error::set(2, runtime_current_line); return false; }
+    return result_ptr;
+}
+
 // Level 4: Handles *, /, and MOD with element-wise array operations
 BasicValue NeReLaBasic::parse_factor() {
     BasicValue left = parse_unary();
@@ -1978,97 +2123,28 @@ BasicValue NeReLaBasic::parse_factor() {
             pcode++;
             BasicValue right = parse_unary();
 
-            left = std::visit([op, this](auto&& l, auto&& r) -> BasicValue {
-                using LeftT = std::decay_t<decltype(l)>;
-                using RightT = std::decay_t<decltype(r)>;
-
-                // Case 1: Array-Array operation
-                if constexpr (std::is_same_v<LeftT, std::shared_ptr<Array>> && std::is_same_v<RightT, std::shared_ptr<Array>>) {
-                    if (!l || !r) { Error::set(15, runtime_current_line); return false; } // Null array error
-                    if (l->shape != r->shape) { Error::set(15, runtime_current_line); return false; } // Shape mismatch
-
-                    auto result_ptr = std::make_shared<Array>();
-                    result_ptr->shape = l->shape;
-                    result_ptr->data.reserve(l->data.size());
-
-                    for (size_t i = 0; i < l->data.size(); ++i) {
-                        double left_val = to_double(l->data[i]);
-                        double right_val = to_double(r->data[i]);
-                        if (op == Tokens::ID::C_ASTR) result_ptr->data.push_back(left_val * right_val);
-                        else if (op == Tokens::ID::C_CARET) result_ptr->data.push_back(pow(left_val,right_val));
-                        else if (op == Tokens::ID::C_SLASH) {
-                            if (right_val == 0.0) { Error::set(2, runtime_current_line); return false; }
-                            result_ptr->data.push_back(left_val / right_val);
-                        } else if (op == Tokens::ID::MOD) {
-                            long long left_val = static_cast<long long>(to_double(l->data[i]));
-                            long long right_val = static_cast<long long>(to_double(r->data[i]));
-                            if (right_val == 0) { Error::set(2, runtime_current_line); return false; }
-                            result_ptr->data.push_back(static_cast<double>(left_val % right_val));
-                        }
-                    }
-                    return result_ptr;
-                }
-                // Case 2: Array-Scalar operation
-                else if constexpr (std::is_same_v<LeftT, std::shared_ptr<Array>>) {
-                    if (!l) { Error::set(15, runtime_current_line); return false; }
-                    double scalar = to_double(r);
-                    auto result_ptr = std::make_shared<Array>();
-                    result_ptr->shape = l->shape;
-                    result_ptr->data.reserve(l->data.size());
-                    for (const auto& elem : l->data) {
-                        if (op == Tokens::ID::C_ASTR) result_ptr->data.push_back(to_double(elem) * scalar);
-                        else if (op == Tokens::ID::C_CARET) result_ptr->data.push_back(pow(to_double(elem),scalar));
-                        else if (op == Tokens::ID::C_SLASH) {
-                            if (scalar == 0.0) { Error::set(2, runtime_current_line); return false; }
-                            result_ptr->data.push_back(to_double(elem) / scalar);
-                        } else if (op == Tokens::ID::MOD) {
-                            long long right_scalar = static_cast<long long>(scalar);
-                            long long left_val = static_cast<long long>(to_double(elem));
-                            if (right_scalar == 0) { Error::set(2, runtime_current_line); return false; }
-                            result_ptr->data.push_back(static_cast<double>(left_val % right_scalar));
-                        }
-                    }
-                    return result_ptr;
-                }
-                // Case 3: Scalar-Array operation
-                else if constexpr (std::is_same_v<RightT, std::shared_ptr<Array>>) {
-                    if (!r) { Error::set(15, runtime_current_line); return false; }
-                    double scalar = to_double(l);
-                    auto result_ptr = std::make_shared<Array>();
-                    result_ptr->shape = r->shape;
-                    result_ptr->data.reserve(r->data.size());
-                    for (const auto& elem : r->data) {
-                        if (op == Tokens::ID::C_ASTR) result_ptr->data.push_back(scalar * to_double(elem));
-                        else if (op == Tokens::ID::C_CARET) result_ptr->data.push_back(pow(scalar, to_double(elem)));
-                        else if (op == Tokens::ID::C_SLASH) {
-                            if (to_double(elem) == 0.0) { Error::set(2, runtime_current_line); return false; }
-                            result_ptr->data.push_back(scalar / to_double(elem));
-                        } else if (op == Tokens::ID::MOD) {
-                            long long left_scalar = static_cast<long long>(scalar);
-                            long long right_val = static_cast<long long>(to_double(elem));
-                            if (right_val == 0) { Error::set(2, runtime_current_line); return false; }
-                            result_ptr->data.push_back(static_cast<double>(left_scalar % right_val));
-                        }
-                    }
-                    return result_ptr;
-                }
-                // Case 4: Fallback to simple scalar operation
-                else {
-                    if (op == Tokens::ID::C_ASTR) return to_double(l) * to_double(r);
-                    if (op == Tokens::ID::C_SLASH) {
-                        double right_val = to_double(r);
-                        if (right_val == 0.0) { Error::set(2, runtime_current_line); return false; }
-                        return to_double(l) / right_val;
-                    }
-                    if (op == Tokens::ID::MOD) {
-                        long long left_val = static_cast<long long>(to_double(l));
-                        long long right_val = static_cast<long long>(to_double(r));
-                        if (right_val == 0) { Error::set(2, runtime_current_line); return false; }
-                        return static_cast<double>(left_val % right_val);
-                    }
-                    return false; // Should not happen
-                }
-                }, left, right);
+            // Cases 1-3: any array operand goes through the fused kernels.
+            if (std::holds_alternative<std::shared_ptr<Array>>(left) || std::holds_alternative<std::shared_ptr<Array>>(right)) {
+                BasicValue result = apply_array_arithmetic(op, left, right);
+                left = std::move(result);
+                continue;
+            }
+
+            // Case 4: Fallback to simple scalar operation
+            double left_val = to_double(left);
+            double right_val = to_double(right);
+            if (op == Tokens::ID::C_ASTR) left = left_val * right_val;
+            else if (op == Tokens::ID::C_CARET) left = std::pow(left_val, right_val);
+            else if (op == Tokens::ID::C_SLASH) {
+                if (right_val == 0.0) { Error::set(2, runtime_current_line); return false; }
+                left = left_val / right_val;
+            }
+            else if (op == Tokens::ID::MOD) {
+                long long left_int = static_cast<long long>(left_val);
+                long long right_int = static_cast<long long>(right_val);
+                if (right_int == 0) { Error::set(2, runtime_current_line); return false; }
+                left = static_cast<double>(left_int % right_int);
+            }
         }
         else break;
     }
@@ -2077,75 +2153,45 @@ BasicValue NeReLaBasic::parse_factor() {
 
 // Level 3: Handles + and - with element-wise array and string operations
 BasicValue NeReLaBasic::parse_term() {
-    BasicValue left = parse_factor();
+    return parse_term_rest(parse_factor());
+}
+
+BasicValue NeReLaBasic::parse_term_rest(BasicValue left) {
     while (true) {
         Tokens::ID op = static_cast<Tokens::ID>((*active_p_code)[pcode]);
         if (op == Tokens::ID::C_PLUS || op == Tokens::ID::C_MINUS) {
             pcode++;
             BasicValue right = parse_factor();
 
-            left = std::visit([op, this](auto&& l, auto&& r) -> BasicValue {
-                using LeftT = std::decay_t<decltype(l)>;
-                using RightT = std::decay_t<decltype(r)>;
-
-                // Case 1: Array-Array operation
-                if constexpr (std::is_same_v<LeftT, std::shared_ptr<Array>> && std::is_same_v<RightT, std::shared_ptr<Array>>) {
-                    if (!l || !r) { Error::set(15, runtime_current_line); return false; }
-                    if (l->shape != r->shape) { Error::set(15, runtime_current_line); return false; }
-
-                    auto result_ptr = std::make_shared<Array>();
-                    result_ptr->shape = l->shape;
-                    result_ptr->data.reserve(l->data.size());
-                    for (size_t i = 0; i < l->data.size(); ++i) {
-                        if (op == Tokens::ID::C_PLUS) result_ptr->data.push_back(to_double(l->data[i]) + to_double(r->data[i]));
-                        else result_ptr->data.push_back(to_double(l->data[i]) - to_double(r->data[i]));
-                    }
-                    return result_ptr;
-                }
-                // Case 2: Array-Scalar operation
-                else if constexpr (std::is_same_v<LeftT, std::shared_ptr<Array>>) {
-                    if (!l) { Error::set(15, runtime_current_line); return false; }
-                    double scalar = to_double(r);
-                    auto result_ptr = std::make_shared<Array>();
-                    result_ptr->shape = l->shape;
-                    result_ptr->data.reserve(l->data.size());
-                    for (const auto& elem : l->data) {
-                        if (op == Tokens::ID::C_PLUS) result_ptr->data.push_back(to_double(elem) + scalar);
-                        else result_ptr->data.push_back(to_double(elem) - scalar);
-                    }
-                    return result_ptr;
-                }
-                // Case 3: Scalar-Array operation
-                else if constexpr (std::is_same_v<RightT, std::shared_ptr<Array>>) {
-                    if (!r) { Error::set(15, runtime_current_line); return false; }
-                    double scalar = to_double(l);
-                    auto result_ptr = std::make_shared<Array>();
-                    result_ptr->shape = r->shape;
-                    result_ptr->data.reserve(r->data.size());
-                    for (const auto& elem : r->data) {
-                        if (op == Tokens::ID::C_PLUS) result_ptr->data.push_back(scalar + to_double(elem));
-                        else result_ptr->data.push_back(scalar - to_double(elem));
-                    }
-                    return result_ptr;
-                }
-                // --- THIS IS THE FIX ---
-                // First, check the TYPES at compile time.
-                else if constexpr (std::is_same_v<LeftT, std::string> || std::is_same_v<RightT, std::string>) {
-                    // Then, check the OPERATOR VALUE at runtime.
-                    if (op == Tokens::ID::C_PLUS) {
-                        return to_string(l) + to_string(r);
+            // Cases 1-3: any array operand goes through the fused kernels.
+            if (std::holds_alternative<std::shared_ptr<Array>>(left) || std::holds_alternative<std::shared_ptr<Array>>(right)) {
+                BasicValue result = apply_array_arithmetic(op, left, right);
+                left = std::move(result);
+                continue;
+            }
+
+            // Case 4: String concatenation
+            if (std::holds_alternative<std::string>(left) || std::holds_alternative<std::string>(right)) {
+                if (op == Tokens::ID::C_PLUS) {
+                    // Append to a string operand in place; a chain A$ + B$ + C$ grows one buffer.
+                    if (auto* text = std::get_if<std::string>(&left)) {
+                        if (const auto* more = std::get_if<std::string>(&right)) *text += *more;
+                        else *text += to_string(right);
                     }
-                    else { // Cannot subtract strings
-                        Error::set(15, runtime_current_line); // Type Mismatch
-                        return false;
+                    else {
+                        left = to_string(left) + to_string(right);
                     }
                 }
-                // Case 5: Fallback to simple scalar operation
-                else {
-                    if (op == Tokens::ID::C_PLUS) return to_double(l) + to_double(r);
-                    else return to_double(l) - to_double(r);
+                else { // Cannot subtract strings
+                    Error::set(15, runtime_current_line); // Type Mismatch
+                    return false;
                 }
-                }, left, right);
+                continue;
+            }
+
+            // Case 5: Fallback to simple scalar operation
+            if (op == Tokens::ID::C_PLUS) left = to_double(left) + to_double(right);
+            else left = to_double(left) - to_double(right);
         }
         else {
             break;
@@ -2156,8 +2202,10 @@ BasicValue NeReLaBasic::parse_term() {
 
 // Level 2: Handles <, >, = with element-wise array operations
 BasicValue NeReLaBasic::parse_comparison() {
-    BasicValue left = parse_term(); // parse_term handles + and -
+    return parse_comparison_rest(parse_term()); // parse_term handles + and -
+}
 
+BasicValue NeReLaBasic::parse_comparison_rest(BasicValue left) {
     Tokens::ID op = static_cast<Tokens::ID>((*active_p_code)[pcode]);
 
     // Check if the next token is ANY of our comparison operators
@@ -2285,7 +2333,10 @@ BasicValue NeReLaBasic::parse_comparison() {
 
 // Level 1: Handles AND, OR
 BasicValue NeReLaBasic::evaluate_expression() {
-    BasicValue left = parse_comparison();
+    return evaluate_expression_rest(parse_comparison());
+}
+
+BasicValue NeReLaBasic::evaluate_expression_rest(BasicValue left) {
     while (true) {
         Tokens::ID op = static_cast<Tokens::ID>((*active_p_code)[pcode]);
         if (op == Tokens::ID::AND || op == Tokens::ID::OR) {
@@ -2297,4 +2348,12 @@ BasicValue NeReLaBasic::evaluate_expression() {
         else break;
     }
     return left;
+}
+
+BasicValue NeReLaBasic::continue_expression(BasicValue left) {
+    left = parse_term_rest(std::move(left));
+    if (Error::get() != 0) return {};
+    left = parse_comparison_rest(std::move(left));
+    if (Error::get() != 0) return {};
+    return evaluate_expression_rest(std::move(left));
 }
\ No newline at end of file
@@ -8,6 +8,7 @@
 #include "Types.hpp"
 #include "Tokens.hpp"
 #include "NetworkManager.hpp"
+#include "FileIO.hpp"
 #include <functional> 
 #include <future>
 #ifdef SDL3
@@ -183,6 +184,22 @@ public:
     NetworkManager network_manager;
 #endif
 
+    // --- Open CSV cursors (CSVOPEN / CSVNEXT / CSVCLOSE), keyed by handle number ---
+    std::map<int, std::unique_ptr<FileIO::CsvReader>> csv_cursors;
+    int next_csv_cursor = 1;
+
+    // --- Open text files (FILE.OPEN / FILE.READLINE$ / FILE.WRITELINE / FILE.CLOSE) ---
+    std::map<int, std::unique_ptr<FileIO::TextFile>> file_handles;
+    int next_file_handle = 1;
+
+    // --- Open JSON record readers (JSON.OPEN / JSON.NEXT / JSON.CLOSE) ---
+    std::map<int, std::unique_ptr<FileIO::JsonReader>> json_readers;
+    int next_json_reader = 1;
+
+    // --- String builders (STRINGBUILDER / SB.APPEND / SB.TOSTRING$), keyed by handle number ---
+    std::map<int, std::string> string_builders;
+    int next_string_builder = 1;
+
     // --- Error Handling State ---
     bool error_handler_active = false;
     std::string error_handler_function_name = ""; // Name of the function to call on error
@@ -208,6 +225,8 @@ public:
     NeReLaBasic(); // Constructor
     void start();  // The main REPL
     void execute(const std::vector<uint8_t>& code_to_run, bool resume_mode);
+    // Closes everything a program opened through handles, so nothing outlives a run.
+    void close_program_resources();
     bool loadSourceFromFile(const std::string& filename);
     std::pair<BasicValue, std::string> resolve_dot_chain(const std::string& chain_string);
     void pre_scan_and_parse_types();
@@ -216,10 +235,17 @@ public:
     BasicValue evaluate_expression();
     BasicValue parse_comparison();
     BasicValue parse_term();
+    BasicValue parse_term_rest(BasicValue left);
+    BasicValue parse_comparison_rest(BasicValue left);
+    BasicValue evaluate_expression_rest(BasicValue left);
     BasicValue parse_primary();
     BasicValue parse_unary();
     BasicValue parse_factor();
     BasicValue parse_array_literal();
+    BasicValue apply_array_arithmetic(Tokens::ID op, const BasicValue& left, const BasicValue& right);
+    // Finishes an expression whose leading operand, and any '+' / '-' terms up to pcode,
+    // have already been evaluated into 'left'.
+    BasicValue continue_expression(BasicValue left);
     bool compile_module(const std::string& module_name, const std::string& module_source_code);
     uint8_t tokenize_program(std::vector<uint8_t>& out_p_code, const std::string& source);
     void statement();
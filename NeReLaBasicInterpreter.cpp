@@ -77,6 +77,7 @@ int main(int argc, char* argv[]) {
             // The file is now loaded and compiled. Start the execution loop.
             // The loop will immediately pause and wait for a 'continue' or 'step' command.
             interpreter.execute(interpreter.program_p_code, false);
+            interpreter.close_program_resources();
         }
         else {
             TextIO::print("? DAP Error: Launch failed. Shutting down.\n");
@@ -85,6 +86,7 @@ int main(int argc, char* argv[]) {
         dap_server.stop();
 
         TextIO::print("\n--- ENDED (Press any key to exit) ---\n");
+        TextIO::flush();
         _getch();
     }
     else {
@@ -100,6 +102,7 @@ int main(int argc, char* argv[]) {
                 Commands::do_run(interpreter);
 
                 TextIO::print("\n--- ENDED (Press any key to exit) ---\n");
+                TextIO::flush();
                 _getch();
             }
             // Note: If do_run encounters a runtime error, it is handled internally
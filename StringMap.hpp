@@ -0,0 +1,280 @@
+// StringMap.hpp
+#pragma once
+#include <string>
+#include <string_view>
+#include <vector>
+#include <utility>
+#include <algorithm>
+#include <functional>
+#include <iterator>
+#include <stdexcept>
+#include <cstddef>
+#include <cstdint>
+
+// A hash map with string keys behind the BASIC Map type.
+// - Open addressing with linear probing over a power-of-two bucket table; every bucket
+//   holds the index of an entry, and entries are kept in insertion order.
+// - Lookups take a std::string_view, so no temporary std::string is built for a key.
+// - In sorted mode, iteration visits the keys in ascending order (like std::map).
+// The interface follows std::map where the interpreter uses it. Inserting or erasing
+// invalidates iterators and references.
+template <typename V>
+class StringMap {
+public:
+    using key_type = std::string;
+    using mapped_type = V;
+    using value_type = std::pair<std::string, V>;
+
+private:
+    struct Slot {
+        value_type kv;
+        size_t hash = 0;
+        bool erased = false;
+    };
+
+    // Bucket values: 0 = empty, 1 = deleted, n >= 2 = entry n - 2.
+    static constexpr uint32_t EMPTY = 0;
+    static constexpr uint32_t DELETED = 1;
+    static constexpr uint32_t FIRST_ENTRY = 2;
+    static constexpr size_t MIN_BUCKETS = 8;
+
+    template <bool IsConst>
+    class basic_iterator {
+        using slots_type = std::conditional_t<IsConst, const std::vector<Slot>, std::vector<Slot>>;
+    public:
+        using iterator_category = std::forward_iterator_tag;
+        using value_type = StringMap::value_type;
+        using difference_type = std::ptrdiff_t;
+        using reference = std::conditional_t<IsConst, const value_type&, value_type&>;
+        using pointer = std::conditional_t<IsConst, const value_type*, value_type*>;
+
+        basic_iterator() = default;
+        basic_iterator(slots_type* slots, size_t pos) : slots(slots), pos(pos) { skip_erased(); }
+        // An iterator converts to a const_iterator.
+        operator basic_iterator<true>() const { return basic_iterator<true>(slots, pos); }
+
+        reference operator*() const { return (*slots)[pos].kv; }
+        pointer operator->() const { return &(*slots)[pos].kv; }
+        basic_iterator& operator++() { ++pos; skip_erased(); return *this; }
+        basic_iterator operator++(int) { basic_iterator old = *this; ++*this; return old; }
+        bool operator==(const basic_iterator& other) const { return pos == other.pos; }
+        bool operator!=(const basic_iterator& other) const { return pos != other.pos; }
+
+        size_t index() const { return pos; }
+
+    private:
+        void skip_erased() {
+            while (slots && pos < slots->size() && (*slots)[pos].erased) ++pos;
+        }
+        slots_type* slots = nullptr;
+        size_t pos = 0;
+    };
+
+public:
+    using iterator = basic_iterator<false>;
+    using const_iterator = basic_iterator<true>;
+
+    StringMap() = default;
+    explicit StringMap(bool sorted) : keep_sorted(sorted) {}
+
+    // --- Iteration (insertion order, or key order in sorted mode) ---
+    iterator begin() { sort_if_needed(); return iterator(&slots, 0); }
+    iterator end() { return iterator(&slots, slots.size()); }
+    const_iterator begin() const { const_cast<StringMap*>(this)->sort_if_needed(); return const_iterator(&slots, 0); }
+    const_iterator end() const { return const_iterator(&slots, slots.size()); }
+
+    size_t size() const { return slots.size() - erased_count; }
+    bool empty() const { return size() == 0; }
+
+    void clear() {
+        slots.clear();
+        buckets.clear();
+        erased_count = 0;
+        used_buckets = 0;
+        needs_sort = false;
+    }
+
+    void reserve(size_t count) {
+        slots.reserve(count);
+        if (bucket_count_for(count) > buckets.size()) rehash(bucket_count_for(count));
+    }
+
+    // Sorted mode keeps std::map's ascending key order for iteration. The order is
+    // restored lazily, the next time iteration starts after out-of-order inserts.
+    void set_sorted(bool sorted) {
+        keep_sorted = sorted;
+        needs_sort = sorted && size() > 1;
+    }
+    bool is_sorted() const { return keep_sorted; }
+
+    // --- Lookup ---
+    iterator find(std::string_view key) {
+        size_t pos = find_slot(key, hash_key(key));
+        return pos == npos ? end() : iterator(&slots, pos);
+    }
+    const_iterator find(std::string_view key) const {
+        size_t pos = find_slot(key, hash_key(key));
+        return pos == npos ? end() : const_iterator(&slots, pos);
+    }
+
+    size_t count(std::string_view key) const { return find_slot(key, hash_key(key)) == npos ? 0 : 1; }
+    bool contains(std::string_view key) const { return count(key) != 0; }
+
+    V& at(std::string_view key) {
+        size_t pos = find_slot(key, hash_key(key));
+        if (pos == npos) throw std::out_of_range("StringMap::at: key not found");
+        return slots[pos].kv.second;
+    }
+    const V& at(std::string_view key) const {
+        size_t pos = find_slot(key, hash_key(key));
+        if (pos == npos) throw std::out_of_range("StringMap::at: key not found");
+        return slots[pos].kv.second;
+    }
+
+    // Returns a pointer to the value for key, or nullptr. A single probe sequence.
+    V* find_value(std::string_view key) {
+        size_t pos = find_slot(key, hash_key(key));
+        return pos == npos ? nullptr : &slots[pos].kv.second;
+    }
+    const V* find_value(std::string_view key) const {
+        size_t pos = find_slot(key, hash_key(key));
+        return pos == npos ? nullptr : &slots[pos].kv.second;
+    }
+
+    // --- Insertion ---
+    V& operator[](std::string_view key) { return try_emplace(key).first->second; }
+
+    template <typename... Args>
+    std::pair<iterator, bool> try_emplace(std::string_view key, Args&&... args) {
+        const size_t hash = hash_key(key);
+        size_t pos = find_slot(key, hash);
+        if (pos != npos) return { iterator(&slots, pos), false };
+        pos = insert_new(std::string(key), hash, V(std::forward<Args>(args)...));
+        return { iterator(&slots, pos), true };
+    }
+
+    template <typename M>
+    std::pair<iterator, bool> insert_or_assign(std::string_view key, M&& value) {
+        auto result = try_emplace(key);
+        result.first->second = std::forward<M>(value);
+        return result;
+    }
+
+    std::pair<iterator, bool> insert(value_type kv) {
+        const size_t hash = hash_key(kv.first);
+        size_t pos = find_slot(kv.first, hash);
+        if (pos != npos) return { iterator(&slots, pos), false };
+        pos = insert_new(std::move(kv.first), hash, std::move(kv.second));
+        return { iterator(&slots, pos), true };
+    }
+
+    std::pair<iterator, bool> emplace(std::string_view key, V value) {
+        return try_emplace(key, std::move(value));
+    }
+
+    // --- Removal ---
+    size_t erase(std::string_view key) {
+        size_t pos = find_slot(key, hash_key(key));
+        if (pos == npos) return 0;
+        erase_slot(pos);
+        if (erased_count > 16 && erased_count * 2 > slots.size()) rehash(bucket_count_for(size()));
+        return 1;
+    }
+
+    // Erases the entry at it and returns the iterator to the next one.
+    iterator erase(const_iterator it) {
+        const size_t pos = it.index();
+        if (pos < slots.size() && !slots[pos].erased) erase_slot(pos);
+        return iterator(&slots, pos);
+    }
+
+private:
+    static constexpr size_t npos = static_cast<size_t>(-1);
+
+    static size_t hash_key(std::string_view key) { return std::hash<std::string_view>{}(key); }
+
+    // Buckets needed to hold count entries at a load factor of at most 1/2.
+    static size_t bucket_count_for(size_t count) {
+        size_t n = MIN_BUCKETS;
+        while (n < count * 2) n *= 2;
+        return n;
+    }
+
+    size_t find_slot(std::string_view key, size_t hash) const {
+        if (buckets.empty()) return npos;
+        const size_t mask = buckets.size() - 1;
+        for (size_t b = hash & mask;; b = (b + 1) & mask) {
+            const uint32_t entry = buckets[b];
+            if (entry == EMPTY) return npos;
+            if (entry >= FIRST_ENTRY) {
+                const Slot& slot = slots[entry - FIRST_ENTRY];
+                if (slot.hash == hash && slot.kv.first == key) return entry - FIRST_ENTRY;
+            }
+        }
+    }
+
+    size_t insert_new(std::string key, size_t hash, V value) {
+        if ((used_buckets + 1) * 2 > buckets.size()) {
+            // Grow, unless dropping deleted entries frees enough room.
+            rehash(bucket_count_for(size() + 1));
+        }
+        if (keep_sorted && !needs_sort && !slots.empty() && (slots.back().erased || key < slots.back().kv.first)) {
+            needs_sort = true;
+        }
+
+        const size_t pos = slots.size();
+        slots.push_back(Slot{ value_type(std::move(key), std::move(value)), hash, false });
+        place(pos, hash);
+        return pos;
+    }
+
+    // Puts entry pos into the first free bucket of its probe sequence.
+    void place(size_t pos, size_t hash) {
+        const size_t mask = buckets.size() - 1;
+        size_t b = hash & mask;
+        while (buckets[b] >= FIRST_ENTRY) b = (b + 1) & mask;
+        if (buckets[b] == EMPTY) ++used_buckets;
+        buckets[b] = static_cast<uint32_t>(pos + FIRST_ENTRY);
+    }
+
+    // Marks entry pos as erased and frees its key and value. Entries are only compacted
+    // by the next rehash, so the positions of the other entries stay valid.
+    void erase_slot(size_t pos) {
+        const size_t mask = buckets.size() - 1;
+        size_t b = slots[pos].hash & mask;
+        while (buckets[b] != pos + FIRST_ENTRY) b = (b + 1) & mask;
+        buckets[b] = DELETED;
+
+        Slot& slot = slots[pos];
+        slot.erased = true;
+        slot.kv.first = std::string();
+        slot.kv.second = V();
+        ++erased_count;
+    }
+
+    // Drops erased entries and rebuilds the bucket table with bucket_count buckets.
+    void rehash(size_t bucket_count) {
+        if (erased_count > 0) {
+            slots.erase(std::remove_if(slots.begin(), slots.end(), [](const Slot& s) { return s.erased; }), slots.end());
+            erased_count = 0;
+        }
+        buckets.assign(std::max(bucket_count, bucket_count_for(slots.size())), EMPTY);
+        used_buckets = 0;
+        for (size_t i = 0; i < slots.size(); ++i) place(i, slots[i].hash);
+    }
+
+    void sort_if_needed() {
+        if (!needs_sort) return;
+        needs_sort = false;
+        if (erased_count > 0) rehash(buckets.size());
+        std::sort(slots.begin(), slots.end(), [](const Slot& a, const Slot& b) { return a.kv.first < b.kv.first; });
+        rehash(buckets.size());
+    }
+
+    std::vector<Slot> slots;
+    std::vector<uint32_t> buckets;
+    size_t erased_count = 0;
+    size_t used_buckets = 0; // Buckets that are not EMPTY (entries and deleted markers)
+    bool keep_sorted = false;
+    bool needs_sort = false;
+};
@@ -2,6 +2,13 @@
 #include "StringUtils.hpp"
 #include <cctype>   // Required for isspace, isalpha, isdigit
 #include <algorithm>// Required for std::find_if
+#include <charconv> // Required for std::to_chars
+#include <cstdio>   // Required for std::snprintf
+#include <cstdlib>  // Required for std::strtod
+#include <cstring>  // Required for std::memcpy
+#include <cstdint>
+#include <bit>      // Required for std::popcount
+#include <functional> // Required for std::boyer_moore_horspool_searcher
 
 // A helper function to check if a character is NOT a whitespace.
 // We'll use this with the strip function.
@@ -60,4 +67,196 @@ std::string StringUtils::to_upper(std::string s) {
     std::transform(s.begin(), s.end(), s.begin(),
         [](unsigned char c) { return std::toupper(c); });
     return s;
-}
\ No newline at end of file
+}
+
+void StringUtils::append_number(std::string& out, double value, int precision, char decimal_point) {
+    char buf[512]; // Enough for any double in fixed notation
+    std::to_chars_result res = (precision < 0)
+        ? std::to_chars(buf, buf + sizeof(buf), value)
+        : std::to_chars(buf, buf + sizeof(buf), value, std::chars_format::fixed, precision);
+    char* end = res.ptr;
+    if (res.ec != std::errc()) {
+        int len = std::snprintf(buf, sizeof(buf), "%.*f", precision < 0 ? 6 : precision, value);
+        end = buf + std::min<int>(std::max(len, 0), sizeof(buf) - 1);
+    }
+
+    char* point = std::find(buf, end, '.');
+    if (point != end && std::find(point, end, 'e') == end) {
+        while (end > point && *(end - 1) == '0') --end;
+        if (end - 1 == point) --end;
+    }
+    if (point < end) *point = decimal_point;
+    out.append(buf, end);
+}
+
+bool StringUtils::parse_number(std::string_view text, double& out, char decimal_point, char thousands_sep) {
+    size_t i = 0;
+    while (i < text.size() && std::isspace(static_cast<unsigned char>(text[i]))) ++i;
+    bool negative = false;
+    if (i < text.size() && (text[i] == '+' || text[i] == '-')) {
+        negative = text[i] == '-';
+        ++i;
+    }
+    text.remove_prefix(i);
+    if (text.empty() || text[0] == '-') return false; // from_chars would accept a second sign
+
+    int base = 0;
+    if (text[0] == '$') base = 16;
+    else if (text[0] == '%') base = 2;
+    else if (text.size() > 2 && text[0] == '0' && (text[1] == 'x' || text[1] == 'X')) base = 16;
+    if (base != 0) {
+        text.remove_prefix(text[0] == '0' ? 2 : 1);
+        unsigned long long value = 0;
+        auto [ptr, ec] = std::from_chars(text.data(), text.data() + text.size(), value, base);
+        if (ec != std::errc()) return false;
+        out = negative ? -static_cast<double>(value) : static_cast<double>(value);
+        return true;
+    }
+
+    // Only text written with another decimal separator is copied, e.g. "1.234,5" -> "1234.5".
+    std::string buffer;
+    if (decimal_point != '.' && text.find(decimal_point) != std::string_view::npos) {
+        for (char c : text) {
+            if (c == decimal_point) c = '.';
+            else if (c == thousands_sep) continue;
+            else if (!std::isdigit(static_cast<unsigned char>(c)) && c != 'e' && c != 'E' && c != '+' && c != '-') break;
+            buffer += c;
+        }
+        text = buffer;
+    }
+
+    double value = 0.0;
+    auto [ptr, ec] = std::from_chars(text.data(), text.data() + text.size(), value);
+    if (ptr == text.data()) return false;
+    if (ec == std::errc::result_out_of_range) {
+        // Rare: strtod turns an overflow into infinity and an underflow into zero.
+        value = std::strtod(std::string(text.data(), ptr).c_str(), nullptr);
+    }
+    out = negative ? -value : value;
+    return true;
+}
+
+size_t StringUtils::find(std::string_view text, std::string_view needle, size_t from) {
+    if (from > text.size() || needle.size() > text.size() - from) return std::string_view::npos;
+    if (needle.empty()) return from;
+
+    if (needle.size() >= 16) {
+        // Long needles: the searcher skips ahead by up to the needle length on a mismatch.
+        const std::boyer_moore_horspool_searcher searcher(needle.begin(), needle.end());
+        auto hit = std::search(text.begin() + from, text.end(), searcher);
+        return hit == text.end() ? std::string_view::npos : static_cast<size_t>(hit - text.begin());
+    }
+
+    const char* base = text.data();
+    const char* p = base + from;
+    const char* last = base + text.size() - needle.size(); // Last possible start
+    while (p <= last) {
+        p = static_cast<const char*>(std::memchr(p, needle[0], static_cast<size_t>(last - p) + 1));
+        if (!p) break;
+        if (std::memcmp(p + 1, needle.data() + 1, needle.size() - 1) == 0) return static_cast<size_t>(p - base);
+        ++p;
+    }
+    return std::string_view::npos;
+}
+
+// --- UTF-8 ---
+
+namespace {
+    constexpr uint64_t HIGH_BITS = 0x8080808080808080ull;
+
+    uint64_t load_word(const char* p) {
+        uint64_t word;
+        std::memcpy(&word, p, sizeof(word));
+        return word;
+    }
+
+    // Counts the bytes of a word that start a codepoint. A continuation byte has bit 7 set
+    // and bit 6 clear; shifting left by one moves each byte's bit 6 under its bit 7.
+    int count_lead_bytes(uint64_t word) {
+        return 8 - std::popcount(word & ~(word << 1) & HIGH_BITS);
+    }
+
+    bool is_lead_byte(char c) {
+        return (static_cast<unsigned char>(c) & 0xC0) != 0x80;
+    }
+
+    // Case mappings for codepoints below U+0800 (two-byte sequences) whose other case
+    // has the same encoded length.
+    char32_t upper_codepoint(char32_t c) {
+        if ((c >= 0xE0 && c <= 0xFE && c != 0xF7) || (c >= 0x3B1 && c <= 0x3CB && c != 0x3C2) || (c >= 0x430 && c <= 0x44F)) return c - 0x20;
+        if (c == 0xFF) return 0x178;
+        if (c == 0x3C2) return 0x3A3; // Final sigma
+        if (c >= 0x450 && c <= 0x45F) return c - 0x50;
+        if ((c >= 0x100 && c <= 0x12F) || (c >= 0x132 && c <= 0x137) || (c >= 0x14A && c <= 0x177)) return c & ~char32_t(1);
+        if ((c >= 0x139 && c <= 0x148) || (c >= 0x179 && c <= 0x17E)) return (c % 2 == 0) ? c - 1 : c;
+        return c;
+    }
+
+    char32_t lower_codepoint(char32_t c) {
+        if ((c >= 0xC0 && c <= 0xDE && c != 0xD7) || (c >= 0x391 && c <= 0x3AB && c != 0x3A2) || (c >= 0x410 && c <= 0x42F)) return c + 0x20;
+        if (c == 0x178) return 0xFF;
+        if (c >= 0x400 && c <= 0x40F) return c + 0x50;
+        if ((c >= 0x100 && c <= 0x12F) || (c >= 0x132 && c <= 0x137) || (c >= 0x14A && c <= 0x177)) return c | 1;
+        if ((c >= 0x139 && c <= 0x148) || (c >= 0x179 && c <= 0x17E)) return (c % 2 == 1) ? c + 1 : c;
+        return c;
+    }
+
+    template <typename AsciiMap, typename CodepointMap>
+    void map_case(std::string& s, AsciiMap ascii_map, CodepointMap codepoint_map) {
+        for (size_t i = 0; i < s.size(); ++i) {
+            const unsigned char c = static_cast<unsigned char>(s[i]);
+            if (c < 0x80) {
+                s[i] = static_cast<char>(ascii_map(c));
+            }
+            else if ((c & 0xE0) == 0xC0 && i + 1 < s.size() && !is_lead_byte(s[i + 1])) {
+                const char32_t cp = ((c & 0x1F) << 6) | (static_cast<unsigned char>(s[i + 1]) & 0x3F);
+                const char32_t mapped = codepoint_map(cp);
+                s[i] = static_cast<char>(0xC0 | (mapped >> 6));
+                s[i + 1] = static_cast<char>(0x80 | (mapped & 0x3F));
+                ++i;
+            }
+        }
+    }
+}
+
+bool StringUtils::is_ascii(std::string_view s) {
+    size_t i = 0;
+    uint64_t bits = 0;
+    for (; i + 8 <= s.size(); i += 8) bits |= load_word(s.data() + i);
+    for (; i < s.size(); ++i) bits |= static_cast<unsigned char>(s[i]);
+    return (bits & HIGH_BITS) == 0;
+}
+
+size_t StringUtils::utf8_length(std::string_view s) {
+    size_t count = 0;
+    size_t i = 0;
+    for (; i + 8 <= s.size(); i += 8) count += count_lead_bytes(load_word(s.data() + i));
+    for (; i < s.size(); ++i) count += is_lead_byte(s[i]);
+    return count;
+}
+
+size_t StringUtils::utf8_offset(std::string_view s, size_t count) {
+    if (count == 0) return 0;
+    size_t i = 0;
+    // Skip whole words while the codepoint we are looking for lies beyond them.
+    for (; i + 8 <= s.size(); i += 8) {
+        const size_t leads = count_lead_bytes(load_word(s.data() + i));
+        if (leads > count) break;
+        count -= leads;
+    }
+    for (; i < s.size(); ++i) {
+        if (is_lead_byte(s[i])) {
+            if (count == 0) return i;
+            --count;
+        }
+    }
+    return s.size();
+}
+
+void StringUtils::utf8_to_upper(std::string& s) {
+    map_case(s, [](unsigned char c) { return std::toupper(c); }, upper_codepoint);
+}
+
+void StringUtils::utf8_to_lower(std::string& s) {
+    map_case(s, [](unsigned char c) { return std::tolower(c); }, lower_codepoint);
+}
@@ -1,6 +1,7 @@
 // StringUtils.hpp
 #pragma once
 #include <string>
+#include <string_view>
 
 namespace StringUtils {
     // Checks if a character is a whitespace character.
@@ -29,4 +30,41 @@ namespace StringUtils {
 
     // Converts a string to uppercase.
     std::string to_upper(std::string s);
+
+    // Appends a number formatted like PRINT: fixed notation with 'precision' decimals and
+    // trailing zeros (and a dangling decimal point) removed. A negative precision gives the
+    // shortest text that reads back to the same value.
+    void append_number(std::string& out, double value, int precision = 6, char decimal_point = '.');
+
+    // Reads the number at the start of text the way VAL does: leading blanks and a sign are
+    // skipped, '$' or "0x" starts a hexadecimal and '%' a binary integer (as in BASIC source),
+    // anything else is a decimal number. Reading stops at the first character that cannot
+    // continue the number. If text contains decimal_point, it is read as the decimal separator
+    // and thousands_sep characters are ignored. Returns false if there is no number.
+    bool parse_number(std::string_view text, double& out, char decimal_point = '.', char thousands_sep = '\0');
+
+    // Finds needle in text at or after byte 'from'. Short needles are located with memchr on
+    // their first byte and confirmed with memcmp; longer ones use a Boyer-Moore-Horspool
+    // search. Returns std::string_view::npos if there is no match.
+    size_t find(std::string_view text, std::string_view needle, size_t from = 0);
+
+    // --- UTF-8 ---
+    // Strings are UTF-8. The helpers below scan eight bytes per step, so pure ASCII text
+    // (the common case) costs about as much as a memchr. A codepoint is counted at each byte
+    // that is not a continuation byte (10xxxxxx), so malformed input never splits further.
+
+    // Returns true if the text contains only 7-bit ASCII.
+    bool is_ascii(std::string_view s);
+
+    // Returns the number of codepoints in the text.
+    size_t utf8_length(std::string_view s);
+
+    // Returns the byte offset of the codepoint after the first 'count' codepoints
+    // (s.size() if the text is shorter).
+    size_t utf8_offset(std::string_view s, size_t count);
+
+    // Converts the case of ASCII letters and of the Latin-1, Latin Extended-A, Greek and
+    // Cyrillic letters in place. These mappings never change the encoded length.
+    void utf8_to_upper(std::string& s);
+    void utf8_to_lower(std::string& s);
 }
\ No newline at end of file
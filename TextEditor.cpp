@@ -195,6 +195,7 @@ std::string TextEditor::prompt_user(const std::string& prompt, const std::string
         status_msg = prompt + input;
         draw_status_bar();
         TextIO::locate(screen_rows + 2, prompt.length() + input.length() + 1);
+        TextIO::flush();
         int key = _getch();
         if (key == 13) { // Enter
             status_msg = "";
@@ -276,6 +277,7 @@ void TextEditor::run() {
     while (true) {
         draw_screen();
         TextIO::locate(cy - top_row + 1, cx + 1);
+        TextIO::flush();
         key = _getch();
 
         if (key == CTRL_KEY('x')) { break; }
@@ -6,32 +6,124 @@
 #include <sstream>
 #include <streambuf>
 #include <cstdint> // For uint16_t, uint8_t
+#include <chrono>
+#include <mutex>
+#include <condition_variable>
+#include <thread>
 
+namespace {
+    // Buffered bytes after which the next line break flushes the output.
+    constexpr size_t OUTPUT_FLUSH_BYTES = 1 << 16;
+    // Longest time output is held back, so slow or unterminated output still shows up.
+    constexpr auto OUTPUT_FLUSH_INTERVAL = std::chrono::milliseconds(50);
 
+    struct OutputBuffer {
+        std::mutex mutex;
+        std::condition_variable wake;
+        std::string text;
+        bool buffered = true;
+        bool stopping = false;
+        std::chrono::steady_clock::time_point last_flush = std::chrono::steady_clock::now();
+        std::thread flusher; // Started with the first buffered output
+
+        // Writes out whatever is pending. The caller holds the mutex.
+        void write_out() {
+            if (!text.empty()) {
+                std::cout.write(text.data(), static_cast<std::streamsize>(text.size()));
+                text.clear();
+            }
+            std::cout.flush();
+            last_flush = std::chrono::steady_clock::now();
+        }
+
+        // Background loop that writes out output which has been pending for too long,
+        // e.g. a progress line printed right before a long computation.
+        void flush_stale() {
+            std::unique_lock<std::mutex> lock(mutex);
+            while (!stopping) {
+                // Sleep until there is something to write, then give it a moment to batch up.
+                wake.wait(lock, [this] { return stopping || !text.empty(); });
+                wake.wait_for(lock, OUTPUT_FLUSH_INTERVAL, [this] { return stopping; });
+                if (!text.empty() && std::chrono::steady_clock::now() - last_flush >= OUTPUT_FLUSH_INTERVAL) {
+                    write_out();
+                }
+            }
+        }
+
+        // Output still pending when the program exits is written out here.
+        ~OutputBuffer() {
+            {
+                std::lock_guard<std::mutex> lock(mutex);
+                stopping = true;
+                write_out();
+            }
+            wake.notify_one();
+            if (flusher.joinable()) flusher.join();
+        }
+    };
+
+    OutputBuffer g_output;
+}
 
 void TextIO::print(const std::string& message) {
-    std::cout << message;
+    std::lock_guard<std::mutex> lock(g_output.mutex);
+    if (!g_output.buffered) {
+        std::cout << message;
+        return;
+    }
+    if (!g_output.flusher.joinable()) {
+        g_output.flusher = std::thread(&OutputBuffer::flush_stale, &g_output);
+    }
+    const bool was_empty = g_output.text.empty();
+    g_output.text += message;
+    if (was_empty) g_output.wake.notify_one();
+    if (g_output.text.size() >= OUTPUT_FLUSH_BYTES && message.find('\n') != std::string::npos) {
+        g_output.write_out();
+    }
+}
+
+void TextIO::flush() {
+    std::lock_guard<std::mutex> lock(g_output.mutex);
+    g_output.write_out();
+}
+
+void TextIO::set_buffered(bool on) {
+    std::lock_guard<std::mutex> lock(g_output.mutex);
+    g_output.write_out();
+    g_output.buffered = on;
+}
+
+std::streambuf* TextIO::redirect(std::streambuf* target) {
+    std::lock_guard<std::mutex> lock(g_output.mutex);
+    g_output.write_out(); // Pending output belongs to the old target
+    return std::cout.rdbuf(target);
+}
+
+void TextIO::imbue(const std::locale& loc) {
+    std::lock_guard<std::mutex> lock(g_output.mutex);
+    std::cout.imbue(loc);
 }
 
 void TextIO::print_uw(uint16_t value) {
-    // Explicitly set the stream to decimal mode before printing.
-    std::cout << std::dec << value;
+    print(std::to_string(value));
 }
 
 void TextIO::print_uwhex(uint16_t value) {
     // std::hex makes the output hexadecimal
     // std::setw and std::setfill ensure it's padded with zeros to 4 digits
-    std::cout << '$' << std::hex << std::setw(4) << std::setfill('0') << std::uppercase << value;
+    std::stringstream ss;
+    ss << '$' << std::hex << std::setw(4) << std::setfill('0') << std::uppercase << value;
+    print(ss.str());
 }
 
 void TextIO::nl() {
-    std::cout << '\n';
+    print("\n");
 }
 
 void TextIO::clearScreen() {
     // This is OS-dependent. For now, a simple simulation.
     // On Windows, you could use: system("cls");
-    std::cout << "\x1B[2J\x1B[H";
+    print("\x1B[2J\x1B[H");
 }
 
 void TextIO::setColor(uint8_t foreground, uint8_t background) {
@@ -39,20 +131,20 @@ void TextIO::setColor(uint8_t foreground, uint8_t background) {
     int bgs = 40;
     if (foreground > 7) fgs = 82;
     if (background > 7) bgs = 92;
-    std::cout << "\x1B[" + std::to_string(foreground+fgs) + ";" + std::to_string(background+bgs) + "m";
+    print("\x1B[" + std::to_string(foreground+fgs) + ";" + std::to_string(background+bgs) + "m");
 }
 
 void TextIO::locate(int row, int col) {
     // Using standard ANSI escape codes to position the cursor.
     // BASIC is typically 1-indexed, so we don't need to subtract 1.
-    std::cout << "\x1B[" << row << ";" << col << "H";
+    print("\x1B[" + std::to_string(row) + ";" + std::to_string(col) + "H");
 }
 
 void TextIO::setCursor(bool on) {
     if (on) {
-        std::cout << "\033[?25h"; // ANSI code to show cursor
+        print("\033[?25h"); // ANSI code to show cursor
     }
     else {
-        std::cout << "\033[?25l"; // ANSI code to hide cursor
+        print("\033[?25l"); // ANSI code to hide cursor
     }
-}
\ No newline at end of file
+}
@@ -5,34 +5,61 @@
 #include <string>
 #include <sstream>
 #include <streambuf>
+#include <locale>
 #include <cstdint> // For uint16_t, uint8_t
 
-// The CoutRedirector class from above
+// A namespace for all text input/output related functions
+namespace TextIO {
+    void print(const std::string& message);
+    void print_uw(uint16_t value);
+    void print_uwhex(uint16_t value);
+    void nl(); // Newline
+    void clearScreen();
+    void setColor(uint8_t foreground, uint8_t background);
+    void locate(int row, int col);
+    void setCursor(bool on);
+
+    // Console output is collected in a buffer and written in large blocks: at a line break
+    // once the buffer is large, after it has been held back for a moment, and whenever
+    // flush() is called before waiting for the user (INPUT, key presses, SLEEP).
+    void flush();
+
+    // Switches buffering on or off (OPTION "BUFFERED" / "UNBUFFERED").
+    void set_buffered(bool on);
+
+    // std::cout is also written by the background flush, so it is only ever changed
+    // through these, under the output lock.
+    // Writes out pending output and sends all further output to 'target'.
+    // Returns the previous stream buffer.
+    std::streambuf* redirect(std::streambuf* target);
+    // Sets the locale used for numbers written to std::cout.
+    void imbue(const std::locale& loc);
+}
+
+// Captures console output while it is alive. Output pending when it is created
+// still goes to the console.
 class CoutRedirector {
 private:
     std::stringstream m_targetStream;
-    std::streambuf* m_originalBuffer;
+    std::streambuf* m_originalBuffer = nullptr;
+
+    void restore() {
+        if (m_originalBuffer) {
+            TextIO::redirect(m_originalBuffer);
+            m_originalBuffer = nullptr;
+        }
+    }
 public:
     CoutRedirector() {
-        m_originalBuffer = std::cout.rdbuf();
-        std::cout.rdbuf(m_targetStream.rdbuf());
+        m_originalBuffer = TextIO::redirect(m_targetStream.rdbuf());
     }
     ~CoutRedirector() {
-        std::cout.rdbuf(m_originalBuffer);
+        restore();
     }
-    std::string getString() const {
+    // Ends the capture and returns the captured text. Once output goes back to the
+    // console, the capture stream is no longer written and can be read safely.
+    std::string getString() {
+        restore();
         return m_targetStream.str();
     }
 };
-
-// A namespace for all text input/output related functions
-namespace TextIO {
-    void print(const std::string& message);
-    void print_uw(uint16_t value);
-    void print_uwhex(uint16_t value);
-    void nl(); // Newline
-    void clearScreen();
-    void setColor(uint8_t foreground, uint8_t background);
-    void locate(int row, int col);
-    void setCursor(bool on);
-}
\ No newline at end of file
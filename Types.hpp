@@ -15,6 +15,7 @@
 #include <stdexcept>  // for exceptions
 #include <map>
 #include "json.hpp" 
+#include "StringMap.hpp"
 
 
 // Forward-declare the Array struct so BasicValue can know it exists.
@@ -103,8 +104,20 @@ struct FunctionRef {
     bool operator==(const FunctionRef&) const = default;
 };
 
+// A parsed JSON document. The document is never modified after parsing, so its
+// compact text can be cached once and reused by every JSON.STRINGIFY$ call.
 struct JsonObject {
     nlohmann::json data;
+    mutable std::string compact_text;
+    mutable bool has_compact_text = false;
+
+    const std::string& compact() const {
+        if (!has_compact_text) {
+            compact_text = data.dump();
+            has_compact_text = true;
+        }
+        return compact_text;
+    }
 };
 
 
@@ -156,7 +169,10 @@ struct Array {
 
 // --- A structure to represent a Map (associative array) ---
 struct Map {
-    std::map<std::string, BasicValue> data;
+    // New maps iterate in key order when OPTION "SORTEDMAPS" is set, otherwise in insertion order.
+    static inline bool sorted_by_default = false;
+
+    StringMap<BasicValue> data{ sorted_by_default };
 };
 
 //==============================================================================